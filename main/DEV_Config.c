@@ -27,12 +27,116 @@
 # THE SOFTWARE.
 #
 ******************************************************************************/
+#include <string.h>
 #include "DEV_Config.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "sdkconfig.h"
+#if CONFIG_EPD_BUSY_LIGHT_SLEEP
+#include "esp_pm.h"
+#endif
 
 static const char *TAG = "DEV_Config";
 static spi_device_handle_t s_epd_spi = NULL;
 
+/* DC level for the pre-transaction callback, passed in spi_transaction_t.user */
+#define EPD_DC_COMMAND  0
+#define EPD_DC_DATA     1
+#define EPD_DC_KEEP     2       /* legacy byte API: caller drives DC itself */
+
+#define EPD_POLL_MAX    32      /* shorter payloads: polling beats interrupt setup */
+#define EPD_FILL_CHUNK  500
+
+#define EPD_BUSY_TIMEOUT_MS     10000   /* longest waveform is ~2 s */
+#define EPD_BUSY_RECHECK_MS     100     /* re-read the pin in case an edge was lost */
+#define EPD_LOW_POWER_MIN_MHZ   40      /* XTAL, lowest DFS step */
+
+static DMA_ATTR UBYTE s_fill_buf[EPD_FILL_CHUNK];
+static DEV_SPI_Stats s_stats;
+static volatile TaskHandle_t s_busy_waiter = NULL;
+static bool s_busy_isr = false;
+
+/* BUSY low = panel idle. Level-triggered so it also ends a light sleep;
+ * disarms itself, DEV_Wait_Busy re-arms it for the next wait. */
+static void EPD_Busy_ISR(void *arg)
+{
+    gpio_intr_disable((gpio_num_t)EPD_BUSY_PIN);
+    TaskHandle_t waiter = s_busy_waiter;
+    BaseType_t woken = pdFALSE;
+    if (waiter != NULL) {
+        vTaskNotifyGiveFromISR(waiter, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+static void EPD_Busy_Init(void)
+{
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "GPIO ISR service failed, BUSY is polled: %s", esp_err_to_name(err));
+        return;
+    }
+    gpio_set_intr_type((gpio_num_t)EPD_BUSY_PIN, GPIO_INTR_LOW_LEVEL);
+    gpio_intr_disable((gpio_num_t)EPD_BUSY_PIN);
+    err = gpio_isr_handler_add((gpio_num_t)EPD_BUSY_PIN, EPD_Busy_ISR, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "BUSY ISR failed, BUSY is polled: %s", esp_err_to_name(err));
+        return;
+    }
+#if CONFIG_EPD_BUSY_LIGHT_SLEEP
+    gpio_wakeup_enable((gpio_num_t)EPD_BUSY_PIN, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+#endif
+    s_busy_isr = true;
+}
+
+/* While a waveform runs nothing but the BUSY interrupt is expected: let the
+ * tickless idle task drop into light sleep or at least to the XTAL clock. */
+static void EPD_Busy_LowPower(bool enable)
+{
+#if CONFIG_EPD_BUSY_LIGHT_SLEEP
+    esp_pm_config_t pm = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = enable ? EPD_LOW_POWER_MIN_MHZ : CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = enable,
+    };
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+    }
+#else
+    (void)enable;
+#endif
+}
+
+static void IRAM_ATTR EPD_SPI_PreTransfer(spi_transaction_t *t)
+{
+    uint32_t dc = (uint32_t)(uintptr_t)t->user;
+    if (dc != EPD_DC_KEEP) {
+        gpio_set_level((gpio_num_t)EPD_DC_PIN, dc);
+    }
+}
+
+/* 3-wire: MOSI doubles as SDA for the few register reads */
+static esp_err_t EPD_SPI_AddDevice(int clock_hz)
+{
+    spi_device_interface_config_t devcfg = {};
+    devcfg.mode = 0;
+    devcfg.clock_speed_hz = clock_hz;
+    devcfg.spics_io_num = EPD_CS_PIN;
+    devcfg.flags = SPI_DEVICE_HALFDUPLEX | SPI_DEVICE_3WIRE;
+    devcfg.queue_size = 1;
+    devcfg.pre_cb = EPD_SPI_PreTransfer;
+
+    esp_err_t err = spi_bus_add_device(EPD_SPI_HOST, &devcfg, &s_epd_spi);
+    if (err != ESP_OK) {
+        s_epd_spi = NULL;
+    }
+    return err;
+}
+
 static esp_err_t GPIO_Config(void)
 {
     const uint64_t output_pins = (1ULL << EPD_RST_PIN) |
@@ -101,7 +205,7 @@ UBYTE DEV_Module_Init(void)
     buscfg.sclk_io_num = EPD_SCK_PIN;
     buscfg.quadwp_io_num = GPIO_NUM_NC;
     buscfg.quadhd_io_num = GPIO_NUM_NC;
-    buscfg.max_transfer_sz = 4096;
+    buscfg.max_transfer_sz = EPD_SPI_MAX_TRANSFER;
 
     err = spi_bus_initialize(EPD_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO);
     if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
@@ -109,21 +213,15 @@ UBYTE DEV_Module_Init(void)
         return 1;
     }
 
-    spi_device_interface_config_t devcfg = {};
-    devcfg.mode = 0;
-    devcfg.clock_speed_hz = EPD_SPI_CLOCK_HZ;
-    devcfg.spics_io_num = EPD_CS_PIN;
-    devcfg.flags = SPI_DEVICE_HALFDUPLEX;
-    devcfg.queue_size = 1;
-
-    err = spi_bus_add_device(EPD_SPI_HOST, &devcfg, &s_epd_spi);
+    err = EPD_SPI_AddDevice(EPD_SPI_CLOCK_HZ);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "SPI device add failed: %s", esp_err_to_name(err));
-        s_epd_spi = NULL;
         return 1;
     }
 
-    ESP_LOGI(TAG, "ePaper interface initialized");
+    EPD_Busy_Init();
+    memset(&s_stats, 0, sizeof(s_stats));
+    ESP_LOGI(TAG, "ePaper interface initialized (%d kHz)", EPD_SPI_CLOCK_HZ / 1000);
     return 0;
 }
 
@@ -142,6 +240,7 @@ void DEV_SPI_WriteByte(UBYTE data)
     t.flags = SPI_TRANS_USE_TXDATA;
     t.length = 8;
     t.tx_data[0] = data;
+    t.user = (void *)(uintptr_t)EPD_DC_KEEP;
     spi_device_polling_transmit(s_epd_spi, &t);
 }
 
@@ -155,6 +254,7 @@ UBYTE DEV_SPI_ReadByte()
     spi_transaction_t t = {};
     t.flags = SPI_TRANS_USE_RXDATA;
     t.length = 8;
+    t.user = (void *)(uintptr_t)EPD_DC_KEEP;
     spi_device_polling_transmit(s_epd_spi, &t);
     return t.rx_data[0];
 }
@@ -164,8 +264,212 @@ void DEV_SPI_Write_nByte(UBYTE *pData, UDOUBLE len)
     if (pData == NULL || len == 0) {
         return;
     }
+    if (s_epd_spi == NULL) {
+        ESP_LOGE(TAG, "SPI device not initialized");
+        return;
+    }
+
+    while (len > 0) {
+        UDOUBLE n = (len > EPD_SPI_MAX_TRANSFER) ? EPD_SPI_MAX_TRANSFER : len;
+        spi_transaction_t t = {};
+        t.length = n * 8;
+        t.tx_buffer = pData;
+        t.user = (void *)(uintptr_t)EPD_DC_KEEP;
+        spi_device_transmit(s_epd_spi, &t);
+        pData += n;
+        len -= n;
+    }
+}
+
+/******************************************************************************
+function:
+			Command + data transactions
+******************************************************************************/
+static esp_err_t EPD_SPI_Transmit(uint32_t dc, const UBYTE *pData, UDOUBLE len, bool keep_cs)
+{
+    spi_transaction_t t = {};
+    t.length = len * 8;
+    t.user = (void *)(uintptr_t)dc;
+    if (keep_cs) {
+        t.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
+    }
+
+    if (len <= sizeof(t.tx_data)) {
+        t.flags |= SPI_TRANS_USE_TXDATA;
+        memcpy(t.tx_data, pData, len);
+        return spi_device_polling_transmit(s_epd_spi, &t);
+    }
+
+    t.tx_buffer = pData;
+    if (len <= EPD_POLL_MAX) {
+        return spi_device_polling_transmit(s_epd_spi, &t);
+    }
+    /* DMA; the task sleeps until the transfer-done interrupt */
+    return spi_device_transmit(s_epd_spi, &t);
+}
+
+static void EPD_SPI_Account(int64_t start, UDOUBLE bytes, UDOUBLE transactions)
+{
+    s_stats.bytes += bytes;
+    s_stats.transactions += transactions;
+    s_stats.busy_us += (UDOUBLE)(esp_timer_get_time() - start);
+}
+
+void DEV_EPD_Write(UBYTE Reg, const UBYTE *pData, UDOUBLE len)
+{
+    if (s_epd_spi == NULL) {
+        ESP_LOGE(TAG, "SPI device not initialized");
+        return;
+    }
+    if (pData == NULL) {
+        len = 0;
+    }
+
+    int64_t start = esp_timer_get_time();
+    UDOUBLE total = len + 1;
+    UDOUBLE transactions = 1;
+
+    /* CS_KEEP_ACTIVE needs the bus held across both transactions */
+    spi_device_acquire_bus(s_epd_spi, portMAX_DELAY);
+    esp_err_t err = EPD_SPI_Transmit(EPD_DC_COMMAND, &Reg, 1, len > 0);
+    while (err == ESP_OK && len > 0) {
+        UDOUBLE n = (len > EPD_SPI_MAX_TRANSFER) ? EPD_SPI_MAX_TRANSFER : len;
+        err = EPD_SPI_Transmit(EPD_DC_DATA, pData, n, len > n);
+        pData += n;
+        len -= n;
+        transactions++;
+    }
+    spi_device_release_bus(s_epd_spi);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "SPI write 0x%02X failed: %s", Reg, esp_err_to_name(err));
+    }
+    EPD_SPI_Account(start, total, transactions);
+}
+
+void DEV_EPD_Fill(UBYTE Reg, UBYTE value, UDOUBLE len)
+{
+    if (s_epd_spi == NULL) {
+        ESP_LOGE(TAG, "SPI device not initialized");
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    UDOUBLE total = len + 1;
+    UDOUBLE transactions = 1;
+    memset(s_fill_buf, value, sizeof(s_fill_buf));
+
+    spi_device_acquire_bus(s_epd_spi, portMAX_DELAY);
+    esp_err_t err = EPD_SPI_Transmit(EPD_DC_COMMAND, &Reg, 1, len > 0);
+    while (err == ESP_OK && len > 0) {
+        UDOUBLE n = (len > EPD_FILL_CHUNK) ? EPD_FILL_CHUNK : len;
+        err = EPD_SPI_Transmit(EPD_DC_DATA, s_fill_buf, n, len > n);
+        len -= n;
+        transactions++;
+    }
+    spi_device_release_bus(s_epd_spi);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "SPI fill 0x%02X failed: %s", Reg, esp_err_to_name(err));
+    }
+    EPD_SPI_Account(start, total, transactions);
+}
+
+UBYTE DEV_EPD_Read(UBYTE Reg, UBYTE *pData, UDOUBLE len)
+{
+    if (s_epd_spi == NULL) {
+        ESP_LOGE(TAG, "SPI device not initialized");
+        return 1;
+    }
+    if (pData == NULL || len == 0 || len > 4) {
+        return 1;
+    }
+
+    /* The clock is per device: swap in a slow one for the read and back */
+    spi_bus_remove_device(s_epd_spi);
+    esp_err_t err = EPD_SPI_AddDevice(EPD_SPI_READ_HZ);
+    if (err == ESP_OK) {
+        spi_transaction_t t = {};
+        t.flags = SPI_TRANS_USE_RXDATA;
+        t.rxlength = len * 8;
+        t.user = (void *)(uintptr_t)EPD_DC_DATA;
+
+        spi_device_acquire_bus(s_epd_spi, portMAX_DELAY);
+        err = EPD_SPI_Transmit(EPD_DC_COMMAND, &Reg, 1, true);
+        if (err == ESP_OK) {
+            err = spi_device_polling_transmit(s_epd_spi, &t);
+        }
+        spi_device_release_bus(s_epd_spi);
+        memcpy(pData, t.rx_data, len);
+        spi_bus_remove_device(s_epd_spi);
+    }
+
+    esp_err_t add = EPD_SPI_AddDevice(EPD_SPI_CLOCK_HZ);
+    if (err == ESP_OK) {
+        err = add;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "SPI read 0x%02X failed: %s", Reg, esp_err_to_name(err));
+        return 1;
+    }
+    return 0;
+}
+
+void DEV_SPI_GetStats(DEV_SPI_Stats *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
+
+void DEV_SPI_Report(void)
+{
+    UDOUBLE kbps = s_stats.busy_us ? (UDOUBLE)((uint64_t)s_stats.bytes * 8 * 1000 / s_stats.busy_us) : 0;
+    ESP_LOGI(TAG, "SPI: %lu bytes in %lu transactions, %lu us (%lu kbit/s)",
+             (unsigned long)s_stats.bytes, (unsigned long)s_stats.transactions,
+             (unsigned long)s_stats.busy_us, (unsigned long)kbps);
+}
+
+/******************************************************************************
+function:
+			Wait for BUSY low
+******************************************************************************/
+UDOUBLE DEV_Wait_Busy(int low_power)
+{
+    int64_t start = esp_timer_get_time();
+
+    if (!s_busy_isr) {
+        while (DEV_Digital_Read(EPD_BUSY_PIN) == 1) {
+            DEV_Delay_ms(1);
+        }
+        return (UDOUBLE)(esp_timer_get_time() - start);
+    }
+    if (DEV_Digital_Read(EPD_BUSY_PIN) == 0) {
+        return 0;
+    }
+
+    s_busy_waiter = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);    /* drop a stale notification */
+    if (low_power) {
+        EPD_Busy_LowPower(true);
+    }
+    gpio_intr_enable((gpio_num_t)EPD_BUSY_PIN);
+
+    while (DEV_Digital_Read(EPD_BUSY_PIN) == 1) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EPD_BUSY_RECHECK_MS)) != 0) {
+            continue;
+        }
+        if (esp_timer_get_time() - start > (int64_t)EPD_BUSY_TIMEOUT_MS * 1000) {
+            ESP_LOGE(TAG, "BUSY still high after %d ms", EPD_BUSY_TIMEOUT_MS);
+            break;
+        }
+        gpio_intr_enable((gpio_num_t)EPD_BUSY_PIN);
+    }
 
-    for (UDOUBLE i = 0; i < len; ++i) {
-        DEV_SPI_WriteByte(pData[i]);
+    gpio_intr_disable((gpio_num_t)EPD_BUSY_PIN);
+    if (low_power) {
+        EPD_Busy_LowPower(false);
     }
+    s_busy_waiter = NULL;
+    return (UDOUBLE)(esp_timer_get_time() - start);
 }
@@ -59,12 +59,15 @@ extern "C" {
 #define EPD_RST_PIN   21
 #define EPD_DC_PIN    13
 #define EPD_BUSY_PIN  14
+#define EPD_PWR_PIN   1     /* panel supply enable, active high */
 
 #define GPIO_PIN_SET   1
 #define GPIO_PIN_RESET 0
 
 #define EPD_SPI_HOST      SPI2_HOST
-#define EPD_SPI_CLOCK_HZ  (4 * 1000 * 1000)  /* 4 MHz keeps panel within spec */
+#define EPD_SPI_CLOCK_HZ  (20 * 1000 * 1000) /* SSD1681 write cycle min. 50 ns; pins 10/11/12 are SPI2 IOMUX */
+#define EPD_SPI_MAX_TRANSFER  5000           /* one full 200x200 1bpp frame per DMA transaction */
+#define EPD_SPI_READ_HZ   (2 * 1000 * 1000)  /* SSD1681 read cycle is much slower than write; SDA is bidirectional */
 
 /**
  * GPIO read and write
@@ -94,6 +97,37 @@ void DEV_SPI_WriteByte(UBYTE data);
 UBYTE DEV_SPI_ReadByte();
 void DEV_SPI_Write_nByte(UBYTE *pData, UDOUBLE len);
 
+/**
+ * Command + payload as one transaction: DC is switched by the pre-transaction
+ * callback, CS stays low between command and data. Payloads above a few bytes
+ * go out via DMA while the calling task blocks.
+**/
+void DEV_EPD_Write(UBYTE Reg, const UBYTE *pData, UDOUBLE len);
+void DEV_EPD_Fill(UBYTE Reg, UBYTE value, UDOUBLE len);
+
+/**
+ * Command, then up to 4 bytes read back over SDA (3-wire). The device is
+ * re-added at EPD_SPI_READ_HZ for the read, so keep this off the hot path.
+ * Returns 0 on success.
+**/
+UBYTE DEV_EPD_Read(UBYTE Reg, UBYTE *pData, UDOUBLE len);
+
+typedef struct {
+    UDOUBLE bytes;          /* command + data bytes since DEV_Module_Init */
+    UDOUBLE transactions;
+    UDOUBLE busy_us;        /* time spent inside DEV_EPD_Write/Fill */
+} DEV_SPI_Stats;
+
+void DEV_SPI_GetStats(DEV_SPI_Stats *stats);
+void DEV_SPI_Report(void);
+
+/**
+ * Block until BUSY is low, woken by the BUSY interrupt instead of polling.
+ * low_power: allow light sleep / minimum CPU clock while waiting (waveforms).
+ * Returns how long BUSY stayed high in microseconds.
+**/
+UDOUBLE DEV_Wait_Busy(int low_power);
+
 #ifdef __cplusplus
 }
 #endif
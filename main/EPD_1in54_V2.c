@@ -27,11 +27,17 @@
 # THE SOFTWARE.
 #
 ******************************************************************************/
+#include <string.h>
 #include "EPD_1in54_V2.h"
+#include "wake_arena.h"
+#include "wake_trace.h"
 #include "Debug.h"
+#include "esp_log.h"
+
+static const char *TAG = "EPD_1in54_V2";
 
 // waveform full refresh
-unsigned char WF_Full_1IN54[159] =
+unsigned char WF_Full_1IN54[EPD_1IN54_V2_LUT_BYTES] =
 {											
 0x80,	0x48,	0x40,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
 0x40,	0x48,	0x80,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
@@ -55,7 +61,7 @@ unsigned char WF_Full_1IN54[159] =
 };
 
 // waveform partial refresh(fast)
-unsigned char WF_PARTIAL_1IN54_0[159] =
+unsigned char WF_PARTIAL_1IN54_0[EPD_1IN54_V2_LUT_BYTES] =
 {
 0x0,0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
 0x80,0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
@@ -99,110 +105,139 @@ parameter:
 ******************************************************************************/
 static void EPD_1IN54_V2_SendCommand(UBYTE Reg)
 {
-    DEV_Digital_Write(EPD_DC_PIN, 0);
-    DEV_Digital_Write(EPD_CS_PIN, 0);
-    DEV_SPI_WriteByte(Reg);
-    DEV_Digital_Write(EPD_CS_PIN, 1);
+    DEV_EPD_Write(Reg, NULL, 0);
 }
 
 /******************************************************************************
-function :	send data
+function :	send command with its parameter bytes in one transaction
 parameter:
-    Data : Write data
+     Reg  : Command register
+     Data : Parameter bytes
+     Len  : Number of parameter bytes
 ******************************************************************************/
-static void EPD_1IN54_V2_SendData(UBYTE Data)
+static void EPD_1IN54_V2_Write(UBYTE Reg, const UBYTE *Data, UDOUBLE Len)
 {
-    DEV_Digital_Write(EPD_DC_PIN, 1);
-    DEV_Digital_Write(EPD_CS_PIN, 0);
-    DEV_SPI_WriteByte(Data);
-    DEV_Digital_Write(EPD_CS_PIN, 1);
+    DEV_EPD_Write(Reg, Data, Len);
+}
+
+static void EPD_1IN54_V2_WriteByte(UBYTE Reg, UBYTE Data)
+{
+    DEV_EPD_Write(Reg, &Data, 1);
 }
 
 /******************************************************************************
 function :	Wait until the busy_pin goes LOW
 parameter:
+  LowPower : allow light sleep while waiting (refresh waveforms)
+return    : time BUSY stayed high in microseconds
 ******************************************************************************/
-static void EPD_1IN54_V2_ReadBusy(void)
+static UDOUBLE EPD_1IN54_V2_WaitBusy(int LowPower)
 {
     Debug("e-Paper busy\r\n");
-    while(DEV_Digital_Read(EPD_BUSY_PIN) == 1) {      //LOW: idle, HIGH: busy
-        DEV_Delay_ms(1);
-    }
+    wake_trace_begin(TRACE_EPD_BUSY);
+    UDOUBLE us = DEV_Wait_Busy(LowPower);      //LOW: idle, HIGH: busy
+    wake_trace_end(TRACE_EPD_BUSY);
     Debug("e-Paper busy release\r\n");
+    return us;
+}
+
+static void EPD_1IN54_V2_ReadBusy(void)
+{
+    EPD_1IN54_V2_WaitBusy(0);
+}
+
+static UBYTE s_defer = 0;       // 1: only record the display update, see DeferActivation
+static UBYTE s_pending = 0;     // recorded 0x22 parameter, 0 = none
+
+/******************************************************************************
+function :	Start the display update sequence and wait for it, or only record
+            it while activation is deferred
+parameter:
+    Mode : 0x22 parameter (0xc7 full, 0xcF partial)
+return   : 1 if the waveform has finished, 0 if it is still pending
+******************************************************************************/
+static UBYTE EPD_1IN54_V2_Activate(UBYTE Mode)
+{
+    if (s_defer) {
+        s_pending = Mode;
+        return 0;
+    }
+    EPD_1IN54_V2_WriteByte(0x22, Mode);
+    EPD_1IN54_V2_SendCommand(0x20);
+    UDOUBLE us = EPD_1IN54_V2_WaitBusy(1);
+    ESP_LOGI(TAG, "%s refresh: BUSY %lu ms", (Mode == 0xc7) ? "full" : "partial", (unsigned long)(us / 1000));
+    return 1;
 }
 
 /******************************************************************************
 function :	Turn On Display full
 parameter:
 ******************************************************************************/
-static void EPD_1IN54_V2_TurnOnDisplay(void)
+static UBYTE EPD_1IN54_V2_TurnOnDisplay(void)
 {
-    EPD_1IN54_V2_SendCommand(0x22);
-    EPD_1IN54_V2_SendData(0xc7);
-	EPD_1IN54_V2_SendCommand(0x20);
-    EPD_1IN54_V2_ReadBusy();
+    return EPD_1IN54_V2_Activate(0xc7);
 }
 
 /******************************************************************************
 function :	Turn On Display part
 parameter:
 ******************************************************************************/
-static void EPD_1IN54_V2_TurnOnDisplayPart(void)
+static UBYTE EPD_1IN54_V2_TurnOnDisplayPart(void)
 {
-    EPD_1IN54_V2_SendCommand(0x22);
-    EPD_1IN54_V2_SendData(0xcF);
-    EPD_1IN54_V2_SendCommand(0x20);
-    EPD_1IN54_V2_ReadBusy();
+    return EPD_1IN54_V2_Activate(0xcF);
 }
 
-static void EPD_1IN54_V2_Lut(UBYTE *lut)
+// Waveforms used by Init and Init_Partial, see EPD_1IN54_V2_SetWaveforms
+static const UBYTE *s_lut_full = WF_Full_1IN54;
+static const UBYTE *s_lut_partial = WF_PARTIAL_1IN54_0;
+
+static void EPD_1IN54_V2_Lut(const UBYTE *lut)
 {
-	EPD_1IN54_V2_SendCommand(0x32);
-	for(UBYTE i=0; i<153; i++)
-		EPD_1IN54_V2_SendData(lut[i]);
+	EPD_1IN54_V2_Write(0x32, lut, 153);
 	EPD_1IN54_V2_ReadBusy();
 }
 
-static void EPD_1IN54_V2_SetLut(UBYTE *lut)
+static void EPD_1IN54_V2_SetLut(const UBYTE *lut)
 {
 	EPD_1IN54_V2_Lut(lut);
 	
-    EPD_1IN54_V2_SendCommand(0x3f);
-    EPD_1IN54_V2_SendData(lut[153]);
-	
-    EPD_1IN54_V2_SendCommand(0x03);
-    EPD_1IN54_V2_SendData(lut[154]);
-	
-    EPD_1IN54_V2_SendCommand(0x04);
-    EPD_1IN54_V2_SendData(lut[155]);
-	EPD_1IN54_V2_SendData(lut[156]);
-	EPD_1IN54_V2_SendData(lut[157]);
-	
-	EPD_1IN54_V2_SendCommand(0x2c);
-    EPD_1IN54_V2_SendData(lut[158]);
+    EPD_1IN54_V2_WriteByte(0x3f, lut[153]);
+    EPD_1IN54_V2_WriteByte(0x03, lut[154]);
+    EPD_1IN54_V2_Write(0x04, &lut[155], 3);
+    EPD_1IN54_V2_WriteByte(0x2c, lut[158]);
 }
 
 static void EPD_1IN54_V2_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
 {
-    EPD_1IN54_V2_SendCommand(0x44); // SET_RAM_X_ADDRESS_START_END_POSITION
-    EPD_1IN54_V2_SendData((Xstart>>3) & 0xFF);
-    EPD_1IN54_V2_SendData((Xend>>3) & 0xFF);
-	
-    EPD_1IN54_V2_SendCommand(0x45); // SET_RAM_Y_ADDRESS_START_END_POSITION
-    EPD_1IN54_V2_SendData(Ystart & 0xFF);
-    EPD_1IN54_V2_SendData((Ystart >> 8) & 0xFF);
-    EPD_1IN54_V2_SendData(Yend & 0xFF);
-    EPD_1IN54_V2_SendData((Yend >> 8) & 0xFF);
+    const UBYTE x[2] = { (Xstart>>3) & 0xFF, (Xend>>3) & 0xFF };
+    EPD_1IN54_V2_Write(0x44, x, sizeof(x)); // SET_RAM_X_ADDRESS_START_END_POSITION
+
+    const UBYTE y[4] = { Ystart & 0xFF, (Ystart >> 8) & 0xFF, Yend & 0xFF, (Yend >> 8) & 0xFF };
+    EPD_1IN54_V2_Write(0x45, y, sizeof(y)); // SET_RAM_Y_ADDRESS_START_END_POSITION
 }
 
 static void EPD_1IN54_V2_SetCursor(UWORD Xstart, UWORD Ystart)
 {
-    EPD_1IN54_V2_SendCommand(0x4E); // SET_RAM_X_ADDRESS_COUNTER
-    EPD_1IN54_V2_SendData(Xstart & 0xFF);
+    EPD_1IN54_V2_WriteByte(0x4E, Xstart & 0xFF); // SET_RAM_X_ADDRESS_COUNTER
 
-    EPD_1IN54_V2_SendCommand(0x4F); // SET_RAM_Y_ADDRESS_COUNTER
-    EPD_1IN54_V2_SendData(Ystart & 0xFF);
-    EPD_1IN54_V2_SendData((Ystart >> 8) & 0xFF);
+    const UBYTE y[2] = { Ystart & 0xFF, (Ystart >> 8) & 0xFF };
+    EPD_1IN54_V2_Write(0x4F, y, sizeof(y)); // SET_RAM_Y_ADDRESS_COUNTER
+}
+
+/******************************************************************************
+function :	Gate count, data entry mode and RAM window as set by Init.
+            A hardware reset restores the defaults, so paths that only run
+            Init_Partial must set them again.
+parameter:
+******************************************************************************/
+static void EPD_1IN54_V2_SetRamLayout(void)
+{
+    const UBYTE driver_output[3] = { 0xC7, 0x00, 0x01 };
+    EPD_1IN54_V2_Write(0x01, driver_output, sizeof(driver_output)); //Driver output control
+
+    EPD_1IN54_V2_WriteByte(0x11, 0x01); //data entry mode
+
+	EPD_1IN54_V2_SetWindows(0, EPD_1IN54_V2_HEIGHT-1, EPD_1IN54_V2_WIDTH-1, 0);
 }
 
 /******************************************************************************
@@ -217,30 +252,19 @@ void EPD_1IN54_V2_Init(void)
     EPD_1IN54_V2_SendCommand(0x12);  //SWRESET
     EPD_1IN54_V2_ReadBusy();
 
-    EPD_1IN54_V2_SendCommand(0x01); //Driver output control
-    EPD_1IN54_V2_SendData(0xC7);
-    EPD_1IN54_V2_SendData(0x00);
-    EPD_1IN54_V2_SendData(0x01);
+    EPD_1IN54_V2_SetRamLayout();
 
-    EPD_1IN54_V2_SendCommand(0x11); //data entry mode
-    EPD_1IN54_V2_SendData(0x01);
+    EPD_1IN54_V2_WriteByte(0x3C, 0x01); //BorderWavefrom
 
-	EPD_1IN54_V2_SetWindows(0, EPD_1IN54_V2_HEIGHT-1, EPD_1IN54_V2_WIDTH-1, 0);
+    EPD_1IN54_V2_WriteByte(0x18, 0x80);
 
-    EPD_1IN54_V2_SendCommand(0x3C); //BorderWavefrom
-    EPD_1IN54_V2_SendData(0x01);
-
-    EPD_1IN54_V2_SendCommand(0x18);
-    EPD_1IN54_V2_SendData(0x80);
-
-    EPD_1IN54_V2_SendCommand(0x22); // //Load Temperature and waveform setting.
-    EPD_1IN54_V2_SendData(0XB1);
+    EPD_1IN54_V2_WriteByte(0x22, 0XB1); // //Load Temperature and waveform setting.
     EPD_1IN54_V2_SendCommand(0x20);
+	EPD_1IN54_V2_ReadBusy();
 
     EPD_1IN54_V2_SetCursor(0, EPD_1IN54_V2_HEIGHT-1);
-	EPD_1IN54_V2_ReadBusy();
 	
-	EPD_1IN54_V2_SetLut(WF_Full_1IN54);
+	EPD_1IN54_V2_SetLut(s_lut_full);
 }
 
 /******************************************************************************
@@ -252,28 +276,60 @@ void EPD_1IN54_V2_Init_Partial(void)
 	EPD_1IN54_V2_Reset();
 	EPD_1IN54_V2_ReadBusy();
 	
-	EPD_1IN54_V2_SetLut(WF_PARTIAL_1IN54_0);
-    EPD_1IN54_V2_SendCommand(0x37); 
-    EPD_1IN54_V2_SendData(0x00);  
-    EPD_1IN54_V2_SendData(0x00);  
-    EPD_1IN54_V2_SendData(0x00);  
-    EPD_1IN54_V2_SendData(0x00); 
-    EPD_1IN54_V2_SendData(0x00);  	
-    EPD_1IN54_V2_SendData(0x40);  
-    EPD_1IN54_V2_SendData(0x00);  
-    EPD_1IN54_V2_SendData(0x00);   
-    EPD_1IN54_V2_SendData(0x00);  
-    EPD_1IN54_V2_SendData(0x00);
-	
-    EPD_1IN54_V2_SendCommand(0x3C); //BorderWavefrom
-    EPD_1IN54_V2_SendData(0x80);
-	
-	EPD_1IN54_V2_SendCommand(0x22); 
-	EPD_1IN54_V2_SendData(0xc0); 
-	EPD_1IN54_V2_SendCommand(0x20); 
+	EPD_1IN54_V2_SetLut(s_lut_partial);
+    const UBYTE otp_option[10] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00 };
+    EPD_1IN54_V2_Write(0x37, otp_option, sizeof(otp_option));
+
+    EPD_1IN54_V2_WriteByte(0x3C, 0x80); //BorderWavefrom
+
+	EPD_1IN54_V2_WriteByte(0x22, 0xc0);
+	EPD_1IN54_V2_SendCommand(0x20);
 	EPD_1IN54_V2_ReadBusy();
 }
 
+/******************************************************************************
+function :	Select the waveforms loaded by the next Init / Init_Partial
+parameter:
+    Full    : EPD_1IN54_V2_LUT_BYTES table, NULL for WF_Full_1IN54
+    Partial : EPD_1IN54_V2_LUT_BYTES table, NULL for WF_PARTIAL_1IN54_0
+******************************************************************************/
+void EPD_1IN54_V2_SetWaveforms(const UBYTE *Full, const UBYTE *Partial)
+{
+    s_lut_full = Full ? Full : WF_Full_1IN54;
+    s_lut_partial = Partial ? Partial : WF_PARTIAL_1IN54_0;
+}
+
+/******************************************************************************
+function :	Measure the panel temperature with the internal sensor. Resets
+            the controller, so call it before Init / Init_Partial (the
+            temperature load also replaces the waveform with the OTP one).
+parameter:
+    Temp16 : temperature in 1/16 degC
+return    : 0 on success
+******************************************************************************/
+UBYTE EPD_1IN54_V2_ReadTemperature(int *Temp16)
+{
+    EPD_1IN54_V2_Reset();
+    EPD_1IN54_V2_ReadBusy();
+
+    EPD_1IN54_V2_WriteByte(0x18, 0x80);     // internal temperature sensor
+    EPD_1IN54_V2_WriteByte(0x22, 0xB1);     // load temperature (and OTP waveform)
+    EPD_1IN54_V2_SendCommand(0x20);
+    EPD_1IN54_V2_ReadBusy();
+
+    UBYTE raw[2];
+    if (DEV_EPD_Read(0x1B, raw, sizeof(raw)) != 0) {
+        return 1;
+    }
+    // 12-bit two's complement, MSB first, 1/16 degC per LSB
+    int t = ((int)raw[0] << 4) | (raw[1] >> 4);
+    if (t & 0x800) {
+        t -= 0x1000;
+    }
+    *Temp16 = t;
+    return 0;
+}
+
 /******************************************************************************
 function :	Clear screen
 parameter:
@@ -284,18 +340,10 @@ void EPD_1IN54_V2_Clear(void)
     Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
     Height = EPD_1IN54_V2_HEIGHT;
 
-    EPD_1IN54_V2_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++) {
-        for (UWORD i = 0; i < Width; i++) {
-            EPD_1IN54_V2_SendData(0XFF);
-        }
-    }
-    EPD_1IN54_V2_SendCommand(0x26);
-    for (UWORD j = 0; j < Height; j++) {
-        for (UWORD i = 0; i < Width; i++) {
-            EPD_1IN54_V2_SendData(0XFF);
-        }
-    }
+    wake_trace_begin(TRACE_EPD_SPI);
+    DEV_EPD_Fill(0x24, 0XFF, (UDOUBLE)Width * Height);
+    DEV_EPD_Fill(0x26, 0XFF, (UDOUBLE)Width * Height);
+    wake_trace_end(TRACE_EPD_SPI);
     EPD_1IN54_V2_TurnOnDisplay();
 }
 
@@ -309,14 +357,9 @@ void EPD_1IN54_V2_Display(UBYTE *Image)
     Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
     Height = EPD_1IN54_V2_HEIGHT;
 
-    UDOUBLE Addr = 0;
-    EPD_1IN54_V2_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++) {
-        for (UWORD i = 0; i < Width; i++) {
-            Addr = i + j * Width;
-            EPD_1IN54_V2_SendData(Image[Addr]);
-        }
-    }
+    wake_trace_begin(TRACE_EPD_SPI);
+    EPD_1IN54_V2_Write(0x24, Image, (UDOUBLE)Width * Height);
+    wake_trace_end(TRACE_EPD_SPI);
     EPD_1IN54_V2_TurnOnDisplay();
 }
 
@@ -331,21 +374,10 @@ void EPD_1IN54_V2_DisplayPartBaseImage(UBYTE *Image)
     Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
     Height = EPD_1IN54_V2_HEIGHT;
 
-    UDOUBLE Addr = 0;
-    EPD_1IN54_V2_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++) {
-        for (UWORD i = 0; i < Width; i++) {
-            Addr = i + j * Width;
-            EPD_1IN54_V2_SendData(Image[Addr]);
-        }
-    }
-    EPD_1IN54_V2_SendCommand(0x26);
-    for (UWORD j = 0; j < Height; j++) {
-        for (UWORD i = 0; i < Width; i++) {
-            Addr = i + j * Width;
-            EPD_1IN54_V2_SendData(Image[Addr]);
-        }
-    }
+    wake_trace_begin(TRACE_EPD_SPI);
+    EPD_1IN54_V2_Write(0x24, Image, (UDOUBLE)Width * Height);
+    EPD_1IN54_V2_Write(0x26, Image, (UDOUBLE)Width * Height);
+    wake_trace_end(TRACE_EPD_SPI);
     EPD_1IN54_V2_TurnOnDisplay();
 }
 
@@ -358,16 +390,176 @@ void EPD_1IN54_V2_DisplayPart(UBYTE *Image)
     UWORD Width, Height;
     Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
     Height = EPD_1IN54_V2_HEIGHT;
- 
-    UDOUBLE Addr = 0;
-    EPD_1IN54_V2_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++) {
-        for (UWORD i = 0; i < Width; i++) {
-            Addr = i + j * Width;
-            EPD_1IN54_V2_SendData(Image[Addr]);
+
+    EPD_1IN54_V2_Write(0x24, Image, (UDOUBLE)Width * Height);
+    EPD_1IN54_V2_TurnOnDisplayPart();
+}
+
+/******************************************************************************
+function :	Partial refresh without a preceding full refresh: the previous
+            frame goes to the "old" RAM (0x26), the new one to 0x24. Call
+            after EPD_1IN54_V2_Init_Partial.
+parameter:
+    Old   : frame currently shown on the panel
+    Image : new frame
+******************************************************************************/
+void EPD_1IN54_V2_DisplayPartDiff(const UBYTE *Old, const UBYTE *Image)
+{
+    UWORD Width, Height;
+    Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
+    Height = EPD_1IN54_V2_HEIGHT;
+
+    EPD_1IN54_V2_SetRamLayout();
+
+    wake_trace_begin(TRACE_EPD_SPI);
+    EPD_1IN54_V2_SetCursor(0, EPD_1IN54_V2_HEIGHT-1);
+    EPD_1IN54_V2_Write(0x26, Old, (UDOUBLE)Width * Height);
+    EPD_1IN54_V2_SetCursor(0, EPD_1IN54_V2_HEIGHT-1);
+    EPD_1IN54_V2_Write(0x24, Image, (UDOUBLE)Width * Height);
+    wake_trace_end(TRACE_EPD_SPI);
+    if (EPD_1IN54_V2_TurnOnDisplayPart()) {
+        // Old RAM follows the displayed frame, so the next update can be windowed
+        EPD_1IN54_V2_SyncOldRam(Image);
+    }
+}
+
+/******************************************************************************
+function :	Write one window of the frame into a RAM bank
+parameter:
+    Reg   : 0x24 (new) or 0x26 (old)
+    Image : full frame, the window is cut out of it
+    Win   : window in framebuffer coordinates
+******************************************************************************/
+static void EPD_1IN54_V2_WriteWindow(UBYTE Reg, const UBYTE *Image, const EPD_1IN54_V2_Window *Win)
+{
+    UWORD Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
+
+    // Data entry mode 0x01: X increments, Y counts down from HEIGHT-1
+    UWORD Ytop = EPD_1IN54_V2_HEIGHT - 1 - Win->Ystart;
+    UWORD Ybottom = Ytop - (Win->Height - 1);
+    EPD_1IN54_V2_SetWindows(Win->Xbyte * 8, Ytop, (Win->Xbyte + Win->Wbytes) * 8 - 1, Ybottom);
+    EPD_1IN54_V2_SetCursor(Win->Xbyte, Ytop);
+
+    const UBYTE *src = Image + (UDOUBLE)Win->Ystart * Width + Win->Xbyte;
+    UDOUBLE len = (UDOUBLE)Win->Wbytes * Win->Height;
+    if (Win->Wbytes == Width) {
+        EPD_1IN54_V2_Write(Reg, src, len);
+        return;
+    }
+
+    // Pack the rows so the window still goes out as one transaction
+    UBYTE *buf = wake_arena_alloc(WAKE_ARENA_INTERNAL, len);
+    if (buf == NULL) {
+        for (UWORD j = 0; j < Win->Height; j++) {
+            EPD_1IN54_V2_SetCursor(Win->Xbyte, Ytop - j);
+            EPD_1IN54_V2_Write(Reg, src + (UDOUBLE)j * Width, Win->Wbytes);
         }
+        return;
     }
-    EPD_1IN54_V2_TurnOnDisplayPart();
+    for (UWORD j = 0; j < Win->Height; j++) {
+        memcpy(buf + (UDOUBLE)j * Win->Wbytes, src + (UDOUBLE)j * Width, Win->Wbytes);
+    }
+    EPD_1IN54_V2_Write(Reg, buf, len);
+    wake_arena_free(buf);
+}
+
+/******************************************************************************
+function :	Windowed partial refresh. Both RAM banks must already hold the
+            previous frame (panel kept its RAM since the last update); only
+            the changed windows are sent to 0x24, refreshed, and then copied
+            to 0x26. Call after EPD_1IN54_V2_Init_Partial.
+parameter:
+    Image : new frame
+    Win   : changed windows
+    Count : number of windows
+******************************************************************************/
+void EPD_1IN54_V2_DisplayPartWindows(const UBYTE *Image, const EPD_1IN54_V2_Window *Win, UBYTE Count)
+{
+    EPD_1IN54_V2_SetRamLayout();
+
+    wake_trace_begin(TRACE_EPD_SPI);
+    for (UBYTE i = 0; i < Count; i++) {
+        EPD_1IN54_V2_WriteWindow(0x24, Image, &Win[i]);
+    }
+    wake_trace_end(TRACE_EPD_SPI);
+    if (EPD_1IN54_V2_TurnOnDisplayPart()) {
+        EPD_1IN54_V2_SyncOldRamWindows(Image, Win, Count);
+    }
+    // deferred: the caller syncs the same windows after the waveform
+}
+
+/******************************************************************************
+function :	Copy the displayed frame into the old RAM (0x26) once the
+            waveform has finished, so both banks hold the same image
+parameter:
+    Image : frame shown on the panel
+******************************************************************************/
+void EPD_1IN54_V2_SyncOldRam(const UBYTE *Image)
+{
+    UWORD Width, Height;
+    Width = (EPD_1IN54_V2_WIDTH % 8 == 0)? (EPD_1IN54_V2_WIDTH / 8 ): (EPD_1IN54_V2_WIDTH / 8 + 1);
+    Height = EPD_1IN54_V2_HEIGHT;
+
+    EPD_1IN54_V2_SetRamLayout();
+    EPD_1IN54_V2_SetCursor(0, EPD_1IN54_V2_HEIGHT-1);
+    EPD_1IN54_V2_Write(0x26, Image, (UDOUBLE)Width * Height);
+}
+
+/******************************************************************************
+function :	Copy only the given windows of the displayed frame into the old
+            RAM (0x26) once the waveform has finished; the rest of 0x26
+            already matches
+parameter:
+    Image : frame shown on the panel
+    Win   : windows refreshed by the last update
+    Count : number of windows
+******************************************************************************/
+void EPD_1IN54_V2_SyncOldRamWindows(const UBYTE *Image, const EPD_1IN54_V2_Window *Win, UBYTE Count)
+{
+    EPD_1IN54_V2_SetRamLayout();
+    for (UBYTE i = 0; i < Count; i++) {
+        EPD_1IN54_V2_WriteWindow(0x26, Image, &Win[i]);
+    }
+}
+
+/******************************************************************************
+function :	Defer the display update: Display and Clear only load the RAM and
+            record the update, EPD_1IN54_V2_ActivatePending starts it later
+            without waiting (e.g. right before deep sleep)
+parameter:
+    Defer : 1 to defer, 0 for the normal blocking behaviour
+******************************************************************************/
+void EPD_1IN54_V2_DeferActivation(UBYTE Defer)
+{
+    s_defer = Defer;
+    if (!Defer) {
+        s_pending = 0;
+    }
+}
+
+/******************************************************************************
+function :	Start a recorded display update and return immediately; the
+            controller finishes the waveform on its own
+return   : 1 if an update was started
+******************************************************************************/
+UBYTE EPD_1IN54_V2_ActivatePending(void)
+{
+    if (s_pending == 0) {
+        return 0;
+    }
+    EPD_1IN54_V2_WriteByte(0x22, s_pending);
+    EPD_1IN54_V2_SendCommand(0x20);
+    s_pending = 0;
+    return 1;
+}
+
+/******************************************************************************
+function :	Wait until a running update has finished (BUSY low)
+parameter:
+******************************************************************************/
+void EPD_1IN54_V2_WaitIdle(void)
+{
+    EPD_1IN54_V2_ReadBusy();
 }
 
 /******************************************************************************
@@ -376,7 +568,6 @@ parameter:
 ******************************************************************************/
 void EPD_1IN54_V2_Sleep(void)
 {
-    EPD_1IN54_V2_SendCommand(0x10); //enter deep sleep
-    EPD_1IN54_V2_SendData(0x01);
+    EPD_1IN54_V2_WriteByte(0x10, 0x01); //enter deep sleep
     DEV_Delay_ms(100);
 }
@@ -36,12 +36,35 @@
 #define EPD_1IN54_V2_WIDTH       200
 #define EPD_1IN54_V2_HEIGHT      200
 
+// Waveform table: 153 bytes LUT (0x32), then gate level, VGH, VSH1/VSH2/VSL, VCOM
+#define EPD_1IN54_V2_LUT_BYTES   159
+
+extern unsigned char WF_Full_1IN54[EPD_1IN54_V2_LUT_BYTES];
+extern unsigned char WF_PARTIAL_1IN54_0[EPD_1IN54_V2_LUT_BYTES];
+
+// Byte-aligned RAM window in framebuffer coordinates (row 0 = first row sent)
+typedef struct {
+    UWORD Xbyte;    // first byte column (8 pixels each)
+    UWORD Ystart;   // first row
+    UWORD Wbytes;
+    UWORD Height;
+} EPD_1IN54_V2_Window;
+
 void EPD_1IN54_V2_Init(void);
 void EPD_1IN54_V2_Init_Partial(void);
+void EPD_1IN54_V2_SetWaveforms(const UBYTE *Full, const UBYTE *Partial);
+UBYTE EPD_1IN54_V2_ReadTemperature(int *Temp16);
 void EPD_1IN54_V2_Clear(void);
 void EPD_1IN54_V2_Display(UBYTE *Image);
 void EPD_1IN54_V2_DisplayPartBaseImage(UBYTE *Image);
 void EPD_1IN54_V2_DisplayPart(UBYTE *Image);
+void EPD_1IN54_V2_DisplayPartDiff(const UBYTE *Old, const UBYTE *Image);
+void EPD_1IN54_V2_DisplayPartWindows(const UBYTE *Image, const EPD_1IN54_V2_Window *Win, UBYTE Count);
+void EPD_1IN54_V2_SyncOldRam(const UBYTE *Image);
+void EPD_1IN54_V2_SyncOldRamWindows(const UBYTE *Image, const EPD_1IN54_V2_Window *Win, UBYTE Count);
+void EPD_1IN54_V2_DeferActivation(UBYTE Defer);
+UBYTE EPD_1IN54_V2_ActivatePending(void);
+void EPD_1IN54_V2_WaitIdle(void);
 void EPD_1IN54_V2_Sleep(void);
 
 #endif
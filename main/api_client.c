@@ -1,25 +1,38 @@
 // ==============================================
 // File: main/api_client.c
 // ==============================================
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
-#include "esp_http_client.h"
 #include "esp_log.h"
-#include "esp_crt_bundle.h"
+#include "esp_attr.h"
 #include "cJSON.h"
 
+#include "ride_stream.h"
+#include "https_client.h"
+#include "ride_table.h"
+#include "http_inflate.h"
+#include "dns_cache.h"
+#include "api_client.h"
 #include "coaster_types.h"  // enthält: coaster_data_t, park_data_t, coaster_status_from_string(...)
 #include "wifi_conn.h"      // enthält: bool wifi_conn_wait_ip(TickType_t timeout_ticks)
+#include "wake_cycle.h"
+#include "wake_trace.h"
+#include "wake_arena.h"
+#include "task_pool.h"
 
 static const char* TAG_API = "api_client";
 
-#define API_OPENINGTIMES_URL   "https://api.wartezeiten.app/v1/openingtimes"
-#define API_WAITINGTIMES_URL   "https://api.wartezeiten.app/v1/waitingtimes"
+#define API_HOST               "api.wartezeiten.app"
+#define API_OPENINGTIMES_PATH  "/v1/openingtimes"
+#define API_WAITINGTIMES_PATH  "/v1/waitingtimes"
 #define LANGUAGE               "de"
 
 // -----------------------------------------------------------------------------
@@ -29,261 +42,532 @@ typedef struct {
     char *buf;
     int   cap;
     int   len;
+    http_inflate_t *inflate;    // gesetzt bei Content-Encoding: gzip
+    bool  failed;               // Body nicht vollständig übernommen
 } http_buf_t;
 
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+// -----------------------------------------------------------------------------
+// TLS-Handshake-Statistik (über Deep Sleep in RTC-Memory)
+// -----------------------------------------------------------------------------
+#define TLS_STATS_MAGIC 0x544C5331u  // "TLS1"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t wakes;
+    uint32_t handshakes_full;
+    uint32_t handshakes_resumed;    // Server hat die gespeicherte Session übernommen
+    uint32_t sessions_rejected;     // Session angeboten, trotzdem voller Handshake
+    uint32_t avg_full_ms;           // gleitende Mittelwerte (1/8), TCP + Handshake
+    uint32_t avg_resumed_ms;
+} tls_stats_t;
+
+static RTC_DATA_ATTR tls_stats_t s_tls_stats;
+
+// Zustand des aktuellen Wakes
+static uint32_t s_connects;
+static uint32_t s_resumed;
+static uint32_t s_handshake_ms_total;
+
+static uint32_t avg8(uint32_t avg, uint32_t v)
 {
-    http_buf_t *hb = (http_buf_t*)evt->user_data;
-    if (evt->event_id == HTTP_EVENT_ON_DATA && hb && evt->data_len > 0) {
-        if (hb->len + evt->data_len + 1 > hb->cap) {
-            int newcap = hb->cap ? hb->cap * 2 : 2048;
-            while (newcap < hb->len + evt->data_len + 1) newcap *= 2;
-            char *nb = realloc(hb->buf, newcap);
-            if (!nb) return ESP_ERR_NO_MEM;
-            hb->buf = nb; hb->cap = newcap;
-        }
-        memcpy(hb->buf + hb->len, evt->data, evt->data_len);
-        hb->len += evt->data_len;
-        hb->buf[hb->len] = '\0';
-    }
-    return ESP_OK;
+    return avg ? (avg * 7 + v) / 8 : v;
 }
 
-// Kleiner Helfer: GET ausführen und Body in http_buf_t sammeln
-static bool http_get_to_buf(const char* url,
-                            const char* park_id_header,   // NULL wenn keiner
-                            http_buf_t* hb,
-                            int timeout_ms,
-                            int* out_status)
+static void tls_stats_on_connected(const https_tls_info_t* info)
 {
-    if (!hb) return false;
-    *out_status = -1;
-    *hb = (http_buf_t){0};
-
-    esp_http_client_config_t cfg = {
-        .url = url,
-        .timeout_ms = timeout_ms,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .event_handler = http_event_handler,
-        .user_data = hb,
-        .keep_alive_enable = true,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&cfg);
-    if (!client) return false;
+    s_connects++;
+    s_handshake_ms_total += info->connect_ms;
 
-    esp_http_client_set_header(client, "accept", "application/json");
-    esp_http_client_set_header(client, "language", LANGUAGE);
-    if (park_id_header) esp_http_client_set_header(client, "park", park_id_header);
-    // Falls nötig: Identität statt gzip
-    // esp_http_client_set_header(client, "Accept-Encoding", "identity");
+    if (info->resumed) {
+        s_resumed++;
+        s_tls_stats.handshakes_resumed++;
+        s_tls_stats.avg_resumed_ms = avg8(s_tls_stats.avg_resumed_ms, info->connect_ms);
+    } else {
+        s_tls_stats.handshakes_full++;
+        if (info->offered) s_tls_stats.sessions_rejected++;
+        s_tls_stats.avg_full_ms = avg8(s_tls_stats.avg_full_ms, info->connect_ms);
+    }
+    ESP_LOGI(TAG_API, "TLS verbunden nach %lu ms (%s)", (unsigned long)info->connect_ms,
+             info->resumed ? "Session wiederaufgenommen"
+                           : info->offered ? "voller Handshake, Session abgelehnt" : "voller Handshake");
+}
 
-    esp_err_t err = esp_http_client_perform(client);
-    *out_status = esp_http_client_get_status_code(client);
-    esp_http_client_cleanup(client);
+static void tls_stats_begin_wake(void)
+{
+    if (s_tls_stats.magic != TLS_STATS_MAGIC) {
+        s_tls_stats = (tls_stats_t){ .magic = TLS_STATS_MAGIC };
+    }
+    s_tls_stats.wakes++;
+    s_connects = 0;
+    s_resumed = 0;
+    s_handshake_ms_total = 0;
+}
 
-    if (err != ESP_OK || *out_status < 200 || *out_status >= 300 || hb->len <= 0) {
-        ESP_LOGE(TAG_API, "HTTP fehlgeschlagen: %s, status=%d, len=%d",
-                 esp_err_to_name(err), *out_status, hb->len);
-        return false;
+static void tls_stats_report(void)
+{
+    // Ersparnis: wiederaufgenommene Verbindungen gegenüber dem mittleren vollen Handshake
+    uint32_t saved_ms = 0;
+    if (s_tls_stats.avg_full_ms > s_tls_stats.avg_resumed_ms) {
+        saved_ms = s_resumed * (s_tls_stats.avg_full_ms - s_tls_stats.avg_resumed_ms);
     }
-    return true;
+    ESP_LOGI(TAG_API, "TLS pro Wake: %lu Verbindungsaufbau(ten), %lu ms, davon %lu wiederaufgenommen (ca. %lu ms gespart)",
+             (unsigned long)s_connects, (unsigned long)s_handshake_ms_total,
+             (unsigned long)s_resumed, (unsigned long)saved_ms);
+    ESP_LOGI(TAG_API, "TLS gesamt in %lu Wakes: %lu voll (Ø %lu ms), %lu wiederaufgenommen (Ø %lu ms), %lu Sessions abgelehnt",
+             (unsigned long)s_tls_stats.wakes,
+             (unsigned long)s_tls_stats.handshakes_full, (unsigned long)s_tls_stats.avg_full_ms,
+             (unsigned long)s_tls_stats.handshakes_resumed, (unsigned long)s_tls_stats.avg_resumed_ms,
+             (unsigned long)s_tls_stats.sessions_rejected);
 }
 
 // -----------------------------------------------------------------------------
-// JSON-Helfer
+// Validator-Cache (ETag/Last-Modified bzw. Body-Hash) + letzte Ergebnisse in RTC-Memory
 // -----------------------------------------------------------------------------
-static cJSON* json_find_item_by_name(cJSON* cJSON_root, const char *name)
-{
-    cJSON* cJSON_arr = NULL;
-    if (cJSON_IsArray(cJSON_root)) cJSON_arr = cJSON_root; else if (cJSON_IsObject(cJSON_root)) {
-        cJSON_arr = cJSON_GetObjectItem(cJSON_root, "data");
-        if (!cJSON_IsArray(cJSON_arr)) cJSON_arr = cJSON_GetObjectItem(cJSON_root, "items");
-        if (!cJSON_IsArray(cJSON_arr)) cJSON_arr = cJSON_GetObjectItem(cJSON_root, "results");
-        if (!cJSON_IsArray(cJSON_arr)) {
-            cJSON* cJSON_name = cJSON_GetObjectItem(cJSON_root, "name");
-            if (cJSON_IsString(cJSON_name) && strcasecmp(cJSON_name->valuestring, name) == 0) return cJSON_root;
-        }
-    }
-    if (!cJSON_IsArray(cJSON_arr)) return NULL;
+#define API_CACHE_MAGIC 0x41504944u  // "APID"
+
+typedef struct {
+    char     etag[64];
+    char     last_modified[40];
+    uint32_t body_hash;
+    bool     valid;
+} http_validator_t;
 
-    cJSON* cJSON_item = NULL;
-    cJSON_ArrayForEach(cJSON_item, cJSON_arr) {
-        if (!cJSON_IsObject(cJSON_item)) continue;
-        cJSON* cJSON_name = cJSON_GetObjectItem(cJSON_item, "name");
-        if (cJSON_IsString(cJSON_name) && strcasecmp(cJSON_name->valuestring, name) == 0) return cJSON_item;
+typedef struct {
+    uint32_t         magic;
+    http_validator_t openingtimes;
+    http_validator_t waitingtimes;
+
+    // Ergebnisse der letzten 200-Antwort, werden bei 304 / gleichem Hash wiederverwendet.
+    // Öffnungszeiten gelten für park_day und werden nur einmal pro Tag abgefragt.
+    int32_t          park_day;
+    bool             park_opened_today;
+    time_t           park_open_from;
+    time_t           park_closed_from;
+    ride_table_t     rides;         // alle Attraktionen bis einschließlich der konfigurierten
+    char             coaster_name[RIDE_STREAM_NAME_MAX];
+    uint32_t         ride_hash;     // Konfiguration, zu der die Einträge gehören
+    uint32_t         park_hash;
+} api_cache_t;
+
+static RTC_DATA_ATTR api_cache_t s_cache;
+
+// Validatoren der aktuell laufenden Antwort (aus HTTPS_EVENT_HEADER)
+static http_validator_t s_resp;
+static bool s_resp_gzip;        // Antwort mit Content-Encoding: gzip
+
+static uint32_t fnv1a_update(uint32_t h, const char* data, int len)
+{
+    for (int i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 16777619u;
     }
-    return NULL;
+    return h;
 }
 
-// Deine Art, Strings in Strukturen zu schreiben (mit realloc etc.) bleibt exakt so:
-static bool json_populate_coaster_data(cJSON* cJSON_coaster, coaster_data_t* coaster_data)
+static void http_set_validators(https_client_t* client, const http_validator_t* v)
 {
-    if (!cJSON_coaster || !coaster_data) return false;
-
-    cJSON* cJSON_waitingtime = cJSON_GetObjectItem(cJSON_coaster, "waitingtime");
-    cJSON* cJSON_status      = cJSON_GetObjectItem(cJSON_coaster, "status");
-    cJSON* cJSON_name        = cJSON_GetObjectItem(cJSON_coaster, "name");
+    https_client_set_header(client, "If-None-Match", v->valid && v->etag[0] ? v->etag : NULL);
+    https_client_set_header(client, "If-Modified-Since", v->valid && v->last_modified[0] ? v->last_modified : NULL);
+}
 
-    if (cJSON_IsNumber(cJSON_waitingtime))
-        coaster_data->waitingtime = cJSON_waitingtime->valueint;
+// true, wenn sich die Antwort gegenüber dem gespeicherten Stand nicht geändert hat.
+// Ohne Validatoren vom Server entscheidet der Body-Hash.
+static bool http_response_unchanged(int status, const http_validator_t* stored)
+{
+    if (!stored->valid) return false;     // nichts gespeichert, auch ein 304 hilft nicht
+    if (status == 304) return true;
+    if (s_resp.etag[0] || s_resp.last_modified[0]) return false;
+    return s_resp.body_hash == stored->body_hash;
+}
 
-    coaster_data->status = cJSON_IsString(cJSON_status)
-                         ? coaster_status_from_string(cJSON_status->valuestring)
-                         : COASTER_UNKNOWN;
+static void http_store_validators(http_validator_t* stored)
+{
+    *stored = s_resp;
+    stored->valid = true;
+}
 
-    if (cJSON_IsString(cJSON_name))
-    {
-        if (!coaster_data->name)
-        {
-            coaster_data->name = (char*) malloc( strlen(cJSON_name->valuestring) + 1 );
-            if (!coaster_data->name)
-                return false;
-        }
-        else if (strlen(coaster_data->name) != strlen(cJSON_name->valuestring))
-        {
-            coaster_data->name = (char*) realloc( (void*) coaster_data->name, strlen(cJSON_name->valuestring) + 1 );
-            if (!coaster_data->name)
-                return false;
-        }
-        memcpy ( (void*) coaster_data->name, (const void *) cJSON_name->valuestring, strlen(cJSON_name->valuestring) + 1 );
+static void api_cache_check(const sd_config_t* cfg)
+{
+    if (s_cache.magic != API_CACHE_MAGIC) {
+        memset(&s_cache, 0, sizeof(s_cache));
+        s_cache.magic = API_CACHE_MAGIC;
+    }
+    uint32_t park_hash = fnv1a_update(2166136261u, cfg->park_id, (int)strlen(cfg->park_id));
+    if (s_cache.park_hash != park_hash) {
+        // Anderer Park -> weder Öffnungszeiten noch Wartezeiten passen
+        memset(&s_cache.openingtimes, 0, sizeof(s_cache.openingtimes));
+        memset(&s_cache.waitingtimes, 0, sizeof(s_cache.waitingtimes));
+        s_cache.park_hash = park_hash;
+    }
+    if (s_cache.ride_hash != cfg->ride_hash) {
+        // Andere Attraktion konfiguriert -> gespeicherte waitingtimes passen nicht mehr
+        memset(&s_cache.waitingtimes, 0, sizeof(s_cache.waitingtimes));
+        s_cache.ride_hash = cfg->ride_hash;
     }
-    return true;
 }
 
-static bool json_populate_park_data(cJSON* cJSON_park, park_data_t* park_data)
+int32_t api_day_key(const struct tm* tm_local)
 {
-    if (!cJSON_park || !park_data) return false;
+    if (!tm_local) return -1;
+    return (int32_t)(tm_local->tm_year + 1900) * 1000 + tm_local->tm_yday;
+}
 
-    cJSON* cJSON_opened_today = cJSON_GetObjectItem(cJSON_park, "opened_today");
-    cJSON* cJSON_open_from    = cJSON_GetObjectItem(cJSON_park, "open_from");
-    cJSON* cJSON_closed_from  = cJSON_GetObjectItem(cJSON_park, "closed_from");
+static bool park_cache_valid(int32_t day_key)
+{
+    return day_key >= 0 && s_cache.openingtimes.valid && s_cache.park_day == day_key;
+}
 
-    park_data->opened_today = (cJSON_IsTrue(cJSON_opened_today)) ? true : false;
+static void park_from_cache(park_data_t* park)
+{
+    park->opened_today = s_cache.park_opened_today;
+    park->open_from    = s_cache.park_open_from;
+    park->closed_from  = s_cache.park_closed_from;
+    park->unchanged    = true;
+}
 
-    if (cJSON_IsString(cJSON_open_from))
-    {
-        if (!park_data->open_from)
-        {
-            park_data->open_from = (char*) malloc( strlen(cJSON_open_from->valuestring) + 1 );
-            if (!park_data->open_from)
-                return false;
-        }
-        else if (strlen(park_data->open_from) != strlen(cJSON_open_from->valuestring))
-        {
-            park_data->open_from = (char*) realloc( (void*) park_data->open_from, strlen(cJSON_open_from->valuestring) + 1 );
-            if (!park_data->open_from)
-                return false;
-        }
-        memcpy ( (void*) park_data->open_from, (const void *) cJSON_open_from->valuestring, strlen(cJSON_open_from->valuestring) + 1 );
+static bool http_buf_append(const char* data, size_t len, void* ctx)
+{
+    http_buf_t *hb = (http_buf_t*)ctx;
+    if (hb->len + (int)len + 1 > hb->cap) {
+        int newcap = hb->cap ? hb->cap * 2 : 2048;
+        while (newcap < hb->len + (int)len + 1) newcap *= 2;
+        char *nb = wake_arena_realloc(WAKE_ARENA_PSRAM, hb->buf, newcap);
+        if (!nb) return false;
+        hb->buf = nb; hb->cap = newcap;
     }
+    memcpy(hb->buf + hb->len, data, len);
+    hb->len += len;
+    hb->buf[hb->len] = '\0';
+    return true;
+}
 
-    if (cJSON_IsString(cJSON_closed_from))
-    {
-        if (!park_data->closed_from)
-        {
-            park_data->closed_from = (char*) malloc( strlen(cJSON_closed_from->valuestring) + 1 );
-            if (!park_data->closed_from)
-                return false;
+static void http_event_handler(const https_event_t *evt)
+{
+    if (evt->id == HTTPS_EVENT_CONNECTED) {
+        wake_trace_end(TRACE_TLS);
+        tls_stats_on_connected(evt->tls);
+        wifi_conn_traffic_ok();
+        return;
+    }
+    if (evt->id == HTTPS_EVENT_HEADER && evt->key && evt->value) {
+        if (strcasecmp(evt->key, "ETag") == 0) {
+            strlcpy(s_resp.etag, evt->value, sizeof(s_resp.etag));
+        } else if (strcasecmp(evt->key, "Last-Modified") == 0) {
+            strlcpy(s_resp.last_modified, evt->value, sizeof(s_resp.last_modified));
+        } else if (strcasecmp(evt->key, "Content-Encoding") == 0) {
+            s_resp_gzip = strcasecmp(evt->value, "gzip") == 0 ||
+                          strcasecmp(evt->value, "x-gzip") == 0;
         }
-        else if (strlen(park_data->closed_from) != strlen(cJSON_closed_from->valuestring))
-        {
-            park_data->closed_from = (char*) realloc( (void*) park_data->closed_from, strlen(cJSON_closed_from->valuestring) + 1 );
-            if (!park_data->closed_from)
-                return false;
+    }
+}
+
+// Body in http_buf_t sammeln (bei gzip entpackt)
+static bool http_buf_on_body(int status, const char* data, size_t len, void* ctx)
+{
+    http_buf_t *hb = (http_buf_t*)ctx;
+    (void)status;
+    if (s_resp_gzip) {
+        if (!hb->inflate) hb->inflate = http_inflate_create(http_buf_append, hb);
+        if (!hb->inflate || http_inflate_feed(hb->inflate, data, len) == HTTP_INFLATE_ERROR) {
+            hb->failed = true;
+            return false;
         }
-        memcpy ( (void*) park_data->closed_from, (const void *) cJSON_closed_from->valuestring, strlen(cJSON_closed_from->valuestring) + 1 );
+    } else if (!http_buf_append(data, len, hb)) {
+        hb->failed = true;
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Vertrauensanker: eingebettete CA des API-Hosts statt des vollen Bundles
+// -----------------------------------------------------------------------------
+#if CONFIG_API_TLS_PINNED_CA
+extern const char api_ca_pem_start[] asm("_binary_api_ca_pem_start");
+extern const char api_ca_pem_end[]   asm("_binary_api_ca_pem_end");
+
+// Nach einem Fehlschlag der eingebetteten CA so viele Wakes das Bundle benutzen
+#define API_PIN_BACKOFF_WAKES 60
+
+static RTC_DATA_ATTR uint16_t s_pin_backoff;
+#endif
+
+static bool api_tls_pin_enabled(void)
+{
+#if CONFIG_API_TLS_PINNED_CA
+    if (s_pin_backoff > 0) {
+        s_pin_backoff--;
+        return false;
     }
+    return true;
+#else
+    return false;
+#endif
+}
 
+// true, wenn der letzte Verbindungsaufbau an der Zertifikatsprüfung gescheitert ist
+static bool api_tls_pin_rejected(https_client_t* client)
+{
+    int tls_code = 0;
+    int tls_flags = 0;
+    https_client_get_and_clear_last_tls_error(client, &tls_code, &tls_flags);
+    if (tls_flags == 0) return false;
+
+    ESP_LOGW(TAG_API, "Eingebettete CA abgelehnt (esp-tls 0x%x, verify flags 0x%x), Fallback auf Bundle",
+             tls_code, tls_flags);
+#if CONFIG_API_TLS_PINNED_CA
+    s_pin_backoff = API_PIN_BACKOFF_WAKES;
+#endif
     return true;
 }
 
 // -----------------------------------------------------------------------------
-// Tasks
+// Adresse des API-Hosts (aus dem RTC-Resolver-Cache, sonst live aufgelöst)
 // -----------------------------------------------------------------------------
+static char s_api_addr[DNS_CACHE_IP_LEN];   // leer: https_client löst den Hostnamen selbst auf
+static bool s_api_addr_cached;
+static esp_err_t s_last_err;                // Ergebnis des letzten Verbindungsaufbaus
 
-// Task: Waitingtimes (Attraktion suchen, coaster_data_t* zur Queue schicken)
-static void waitingtimes_task(void* arg)
+static void api_resolve_host(void)
 {
-    void** pack = (void**)arg;
-    QueueHandle_t out_q = (QueueHandle_t)pack[0];
-    const char*   park_id = (const char*)pack[1];
-    const char*   target  = (const char*)pack[2];
-    free(pack);
+    wake_trace_begin(TRACE_DNS);
+    if (!dns_cache_resolve(API_HOST, CONFIG_DNS_CACHE_TTL_S, s_api_addr, sizeof(s_api_addr), &s_api_addr_cached)) {
+        s_api_addr[0] = '\0';
+        s_api_addr_cached = false;
+    }
+    wake_trace_end(TRACE_DNS);
+}
 
-    if (!wifi_conn_wait_ip(pdMS_TO_TICKS(20000))) {
-        ESP_LOGE(TAG_API, "Timeout: keine Wi-Fi Verbindung (waitingtimes)");
-        vTaskDelete(NULL);
-        return;
+// Ein Client für beide Endpunkte: gleicher Host, daher wird die TLS-Verbindung
+// per Keep-Alive wiederverwendet. Jeder neue Verbindungsaufbau bietet die zuletzt
+// gespeicherte Session an, auch die aus dem vorigen Wake (RTC-Memory), und kommt
+// bei Annahme ohne Zertifikatskette und Schlüsselaustausch aus.
+// Verbindung per IP: TLS-Name (SNI, Zertifikat) und Host-Header bleiben der API-Host.
+// use_pinned_ca: nur gegen die eingebettete CA prüfen statt gegen das ganze Bundle.
+static https_client_t* api_http_client_create(const char* park_id_header, int timeout_ms, bool use_pinned_ca)
+{
+    https_client_config_t cfg = {
+        .host = API_HOST,
+        .addr = s_api_addr[0] ? s_api_addr : NULL,
+        .timeout_ms = timeout_ms,
+        .event_handler = http_event_handler,
+    };
+#if CONFIG_API_TLS_PINNED_CA
+    if (use_pinned_ca) {
+        cfg.cert_pem = api_ca_pem_start;
+        cfg.cert_len = api_ca_pem_end - api_ca_pem_start;
     }
+#endif
+    (void)use_pinned_ca;
+    https_client_t* client = https_client_init(&cfg);
+    if (!client) return NULL;
+
+    https_client_set_header(client, "accept", "application/json");
+    https_client_set_header(client, "language", LANGUAGE);
+    if (park_id_header) https_client_set_header(client, "park", park_id_header);
+#if CONFIG_API_HTTP_GZIP
+    https_client_set_header(client, "Accept-Encoding", "gzip");
+#else
+    https_client_set_header(client, "Accept-Encoding", "identity");
+#endif
+    return client;
+}
 
-    http_buf_t http_buf = {0};
-    int status = 0;
-    ESP_LOGI(TAG_API, "Starte API-Request: %s", API_WAITINGTIMES_URL);
+// Kleiner Helfer: GET ausführen und Body in http_buf_t sammeln.
+// Die Antwort wird vollständig gelesen, die Verbindung bleibt danach offen.
+// 304 gilt als Erfolg (leerer Body).
+static bool http_get_to_buf(https_client_t* client,
+                            const char* path,
+                            http_buf_t* hb,
+                            int* out_status)
+{
+    if (!client || !hb) return false;
+    *out_status = -1;
+    *hb = (http_buf_t){0};
 
-    if (!http_get_to_buf(API_WAITINGTIMES_URL, park_id, &http_buf, 10000, &status)) {
-        free(http_buf.buf);
-        vTaskDelete(NULL);
-        return;
+    s_resp = (http_validator_t){ .body_hash = 2166136261u };
+    s_resp_gzip = false;
+    wake_trace_begin(TRACE_TLS);    // bleibt offen, wenn die Verbindung wiederverwendet wird
+    esp_err_t err = https_client_get(client, path, http_buf_on_body, hb, out_status);
+    s_last_err = err;
+    if (err == ESP_OK && hb->failed) err = ESP_FAIL;
+
+    if (hb->inflate) {
+        ESP_LOGI(TAG_API, "gzip: %u Bytes übertragen, %u Bytes entpackt",
+                 (unsigned)http_inflate_total_in(hb->inflate), (unsigned)http_inflate_total_out(hb->inflate));
+        http_inflate_destroy(hb->inflate);
+        hb->inflate = NULL;
     }
-    ESP_LOGI(TAG_API, "Waitingtimes: HTTP Status=%d, empfangen=%d Bytes", status, http_buf.len);
 
-    coaster_data_t* coaster_data = calloc(1, sizeof(*coaster_data));
-    if (!coaster_data) { free(http_buf.buf); vTaskDelete(NULL); return; }
+    if (err == ESP_OK && *out_status == 304) return true;
+    if (hb->len > 0) s_resp.body_hash = fnv1a_update(s_resp.body_hash, hb->buf, hb->len);
 
-    cJSON* cJSON_root = cJSON_Parse(http_buf.buf);
-    if (cJSON_root) {
-        cJSON *coaster = json_find_item_by_name(cJSON_root, target);
-        if (coaster) {
-            (void)json_populate_coaster_data(coaster, coaster_data);
-        } else {
-            ESP_LOGW(TAG_API, "Eintrag '%s' nicht gefunden.", target);
-        }
-        cJSON_Delete(cJSON_root);
-    } else {
-        ESP_LOGE(TAG_API, "Waitingtimes JSON parse error");
+    if (err != ESP_OK || *out_status < 200 || *out_status >= 300 || hb->len <= 0) {
+        ESP_LOGE(TAG_API, "HTTP fehlgeschlagen: %s, status=%d, len=%d",
+                 https_client_err_name(err), *out_status, hb->len);
+        return false;
     }
+    return true;
+}
 
-    if (out_q) {
-        if (xQueueSend(out_q, &coaster_data, pdMS_TO_TICKS(100)) != pdPASS) {
-            ESP_LOGW(TAG_API, "Coaster-Queue voll, Wert nicht gesendet.");
-            free(coaster_data->name); free(coaster_data);
+// Streaming-Variante: Body chunkweise (bei gzip entpackt) an on_chunk reichen statt ihn zu sammeln.
+// on_chunk liefert false, sobald genug gelesen wurde -> Verbindung wird sofort geschlossen,
+// ein weiterer Request verbindet neu. 304 gilt als Erfolg (kein Body).
+typedef bool (*http_chunk_cb_t)(const char* data, int len, void* ctx);
+
+typedef struct {
+    http_chunk_cb_t on_chunk;
+    void*           ctx;
+    int             len;        // entpackte Bytes
+} http_stream_sink_t;
+
+typedef struct {
+    http_stream_sink_t sink;
+    http_inflate_t*    inflate;
+    int                wire_len;
+    bool               failed;
+} http_stream_t;
+
+static bool http_stream_sink(const char* data, size_t len, void* ctx)
+{
+    http_stream_sink_t* sink = (http_stream_sink_t*)ctx;
+    sink->len += (int)len;
+    s_resp.body_hash = fnv1a_update(s_resp.body_hash, data, (int)len);
+    return sink->on_chunk(data, (int)len, sink->ctx);
+}
+
+static bool http_stream_on_body(int status, const char* data, size_t len, void* ctx)
+{
+    http_stream_t* st = (http_stream_t*)ctx;
+    if (status < 200 || status >= 300) return false;    // Fehlerseite nicht lesen
+
+    st->wire_len += (int)len;
+    if (s_resp_gzip) {
+        if (!st->inflate) st->inflate = http_inflate_create(http_stream_sink, &st->sink);
+        if (!st->inflate) {
+            ESP_LOGE(TAG_API, "gzip: kein Speicher für Entpacker");
+            st->failed = true;
+            return false;
         }
-    } else {
-        free(coaster_data->name); free(coaster_data);
+        http_inflate_result_t r = http_inflate_feed(st->inflate, data, len);
+        if (r == HTTP_INFLATE_ERROR) st->failed = true;
+        return r == HTTP_INFLATE_CONTINUE;      // sonst wird der Rest nicht mehr übertragen
     }
-
-    free(http_buf.buf);
-    vTaskDelete(NULL);
+    return http_stream_sink(data, len, &st->sink);
 }
 
-// Task: Openingtimes (Parkdaten holen, park_data_t* zur Queue schicken)
-static void openingtimes_task(void* arg)
+static bool http_get_streamed(https_client_t* client,
+                              const char* path,
+                              http_chunk_cb_t on_chunk,
+                              void* ctx,
+                              int* out_status,
+                              int* out_len)
 {
-    void** pack = (void**)arg;
-    QueueHandle_t out_q = (QueueHandle_t)pack[0];
-    const char*   park_id = (const char*)pack[1];
-    free(pack);
+    if (!client || !on_chunk) return false;
+    *out_status = -1;
+    *out_len = 0;
+
+    s_resp = (http_validator_t){ .body_hash = 2166136261u };
+    s_resp_gzip = false;
+    http_stream_t st = { .sink = { .on_chunk = on_chunk, .ctx = ctx } };
+    wake_trace_begin(TRACE_TLS);
+    esp_err_t err = https_client_get(client, path, http_stream_on_body, &st, out_status);
+    s_last_err = err;
+
+    if (st.inflate) {
+        ESP_LOGI(TAG_API, "gzip: %d Bytes übertragen, %d Bytes entpackt", st.wire_len, st.sink.len);
+        http_inflate_destroy(st.inflate);
+    }
+    *out_len = st.sink.len;
+    if (err == ESP_OK && *out_status == 304) return true;
 
-    if (!wifi_conn_wait_ip(pdMS_TO_TICKS(20000))) {
-        ESP_LOGE(TAG_API, "Timeout: keine Wi-Fi Verbindung (openingtimes)");
-        vTaskDelete(NULL);
-        return;
+    if (err != ESP_OK || st.failed || *out_status < 200 || *out_status >= 300 || *out_len <= 0) {
+        ESP_LOGE(TAG_API, "HTTP fehlgeschlagen: %s, status=%d, len=%d",
+                 https_client_err_name(err), *out_status, *out_len);
+        return false;
     }
+    return true;
+}
+
+static bool ride_stream_chunk(const char* data, int len, void* ctx)
+{
+    return ride_stream_feed((ride_stream_t*)ctx, data, (size_t)len) == RIDE_STREAM_CONTINUE;
+}
+
+// -----------------------------------------------------------------------------
+// JSON-Helfer
+// -----------------------------------------------------------------------------
+static bool populate_coaster_data(const ride_table_t* rides, int slot, const char* name, coaster_data_t* coaster_data)
+{
+    if (!rides || slot < 0 || !coaster_data) return false;
+
+    coaster_data->waitingtime = rides->wait[slot];
+    coaster_data->status      = ride_table_status(rides, slot);
+    strlcpy(coaster_data->name, name ? name : "", sizeof(coaster_data->name));
+    return true;
+}
+
+// "2024-06-01T09:00:00" (lokale Parkzeit) -> time_t; 0 wenn nicht lesbar
+static time_t parse_local_time(const char* str)
+{
+    if (!str) return 0;
+    struct tm tm_val = {0};
+    if (!strptime(str, "%Y-%m-%dT%H:%M:%S", &tm_val)) return 0;
+    tm_val.tm_isdst = -1;   // Sommerzeit aus TZ ableiten
+    time_t t = mktime(&tm_val);
+    return (t == (time_t)-1) ? 0 : t;
+}
+
+static bool json_populate_park_data(cJSON* cJSON_park, park_data_t* park_data)
+{
+    if (!cJSON_park || !park_data) return false;
+
+    cJSON* cJSON_opened_today = cJSON_GetObjectItem(cJSON_park, "opened_today");
+    cJSON* cJSON_open_from    = cJSON_GetObjectItem(cJSON_park, "open_from");
+    cJSON* cJSON_closed_from  = cJSON_GetObjectItem(cJSON_park, "closed_from");
+
+    park_data->opened_today = (cJSON_IsTrue(cJSON_opened_today)) ? true : false;
+
+    if (cJSON_IsString(cJSON_open_from))
+        park_data->open_from = parse_local_time(cJSON_open_from->valuestring);
+
+    if (cJSON_IsString(cJSON_closed_from))
+        park_data->closed_from = parse_local_time(cJSON_closed_from->valuestring);
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Requests
+// -----------------------------------------------------------------------------
 
+// Openingtimes: Body komplett lesen (klein), danach bleibt die Verbindung offen
+static bool fetch_openingtimes(https_client_t* client, int32_t day_key, park_data_t* park)
+{
     http_buf_t hb = {0};
+    memset(park, 0, sizeof(*park));
     int status = 0;
-    ESP_LOGI(TAG_API, "Starte API-Request: %s", API_OPENINGTIMES_URL);
-
-    if (!http_get_to_buf(API_OPENINGTIMES_URL, park_id, &hb, 10000, &status)) {
-        free(hb.buf);
-        vTaskDelete(NULL);
-        return;
+    ESP_LOGI(TAG_API, "Starte API-Request: %s", API_OPENINGTIMES_PATH);
+
+    http_set_validators(client, &s_cache.openingtimes);
+    wake_trace_begin(TRACE_HTTP_OPENINGTIMES);
+    bool ok = http_get_to_buf(client, API_OPENINGTIMES_PATH, &hb, &status);
+    wake_trace_end(TRACE_HTTP_OPENINGTIMES);
+    if (!ok) {
+        wake_arena_free(hb.buf);
+        return false;
     }
     ESP_LOGI(TAG_API, "Openingtimes: HTTP Status=%d, empfangen=%d Bytes", status, hb.len);
 
-    park_data_t* park = calloc(1, sizeof(*park));
-    if (!park) { free(hb.buf); vTaskDelete(NULL); return; }
+    if (http_response_unchanged(status, &s_cache.openingtimes)) {
+        ESP_LOGI(TAG_API, "Openingtimes unverändert, verwende gespeicherte Daten");
+        wake_arena_free(hb.buf);
+        if (day_key >= 0) s_cache.park_day = day_key;
+        park_from_cache(park);
+        return true;
+    }
 
+    wake_trace_begin(TRACE_JSON_PARSE);
     cJSON* root = cJSON_Parse(hb.buf);
     if (root) {
         cJSON* obj = NULL;
@@ -304,6 +588,18 @@ static void openingtimes_task(void* arg)
         if (cJSON_IsObject(obj)) {
             if (!json_populate_park_data(obj, park)) {
                 ESP_LOGW(TAG_API, "json_populate_park_data fehlgeschlagen");
+            } else {
+                http_store_validators(&s_cache.openingtimes);
+                s_cache.park_opened_today = park->opened_today;
+                s_cache.park_open_from    = park->open_from;
+                s_cache.park_closed_from  = park->closed_from;
+                if (day_key < 0 && park->open_from) {
+                    // Datum unbekannt (Kaltstart): Tag aus der Öffnungszeit ableiten
+                    struct tm tm_open = {0};
+                    localtime_r(&park->open_from, &tm_open);
+                    day_key = api_day_key(&tm_open);
+                }
+                s_cache.park_day = day_key;
             }
         } else {
             ESP_LOGW(TAG_API, "Openingtimes: kein Objekt gefunden");
@@ -314,40 +610,205 @@ static void openingtimes_task(void* arg)
     } else {
         ESP_LOGE(TAG_API, "Openingtimes JSON parse error");
     }
+    wake_trace_end(TRACE_JSON_PARSE);
 
+    wake_arena_free(hb.buf);
+    return true;
+}
 
-    if (out_q) {
-        if (xQueueSend(out_q, &park, pdMS_TO_TICKS(100)) != pdPASS) {
-            ESP_LOGW(TAG_API, "Park-Queue voll, Wert nicht gesendet.");
-            free(park->open_from); free(park->closed_from); free(park);
+// Waitingtimes: gestreamt in die Attraktionstabelle, Transfer endet nach dem Treffer
+// -> immer als letzter Request. false bei Fehler oder wenn die Attraktion fehlt.
+static bool fetch_waitingtimes(https_client_t* client, const sd_config_t* cfg, coaster_data_t* coaster_data)
+{
+    ride_stream_t* rs = wake_arena_calloc(WAKE_ARENA_INTERNAL, 1, sizeof(*rs));
+    ride_collect_t* rc = wake_arena_calloc(WAKE_ARENA_INTERNAL, 1, sizeof(*rc));
+    ride_table_t* rides = wake_arena_calloc(WAKE_ARENA_INTERNAL, 1, sizeof(*rides));
+    if (!rs || !rc || !rides) { wake_arena_free(rides); wake_arena_free(rc); wake_arena_free(rs); return false; }
+
+    rc->rides = rides;
+    rc->target = cfg->ride_name;
+    ride_stream_init(rs, ride_collect_item, rc);
+
+    int status = 0;
+    int received = 0;
+    bool ok = false;
+    bool refetch = false;
+    ESP_LOGI(TAG_API, "Starte API-Request: %s", API_WAITINGTIMES_PATH);
+
+    http_set_validators(client, &s_cache.waitingtimes);
+    wake_trace_begin(TRACE_HTTP_WAITINGTIMES);
+    bool got = http_get_streamed(client, API_WAITINGTIMES_PATH, ride_stream_chunk, rs, &status, &received);
+    wake_trace_end(TRACE_HTTP_WAITINGTIMES);
+    if (got) {
+        ESP_LOGI(TAG_API, "Waitingtimes: HTTP Status=%d, empfangen=%d Bytes, %u Attraktionen (Abbruch nach Treffer: %s)",
+                 status, received, (unsigned)rides->count, rs->result == RIDE_STREAM_DONE ? "ja" : "nein");
+        memset(coaster_data, 0, sizeof(*coaster_data));
+
+        if (http_response_unchanged(status, &s_cache.waitingtimes)) {
+            int slot = ride_table_find(&s_cache.rides, cfg->ride_name);
+            ok = populate_coaster_data(&s_cache.rides, slot, s_cache.coaster_name, coaster_data);
+            if (ok) {
+                ESP_LOGI(TAG_API, "Waitingtimes unverändert, verwende gespeicherte Daten");
+                coaster_data->unchanged = true;
+            } else {
+                // Gespeicherte Tabelle passt nicht zu den Validatoren -> ohne sie neu laden
+                ESP_LOGW(TAG_API, "Waitingtimes unverändert, aber '%s' nicht im Cache; lade neu", cfg->ride_name);
+                memset(&s_cache.waitingtimes, 0, sizeof(s_cache.waitingtimes));
+                refetch = true;
+            }
+        } else if (!ride_stream_finish(rs)) {
+            ESP_LOGE(TAG_API, "Waitingtimes JSON parse error");
+        } else if (rc->found) {
+            if (rides->full) ESP_LOGW(TAG_API, "Attraktionstabelle voll (%d Einträge)", RIDE_TABLE_SLOTS);
+            s_cache.rides = *rides;
+            strlcpy(s_cache.coaster_name, rc->name, sizeof(s_cache.coaster_name));
+            ok = populate_coaster_data(&s_cache.rides, ride_table_find(&s_cache.rides, cfg->ride_name),
+                                       s_cache.coaster_name, coaster_data);
+            if (ok) http_store_validators(&s_cache.waitingtimes);
+        } else {
+            ESP_LOGW(TAG_API, "Eintrag '%s' nicht gefunden.", cfg->ride_name);
         }
-    } else {
-        free(park->open_from); free(park->closed_from); free(park);
     }
 
-    free(hb.buf);
-    vTaskDelete(NULL);
+    // Umgekehrte Reihenfolge der Anlage: die Arena gibt nur den obersten Block zurück
+    wake_arena_free(rides);
+    wake_arena_free(rc);
+    wake_arena_free(rs);
+    // Ohne Validatoren ist die Antwort nie "unverändert", daher höchstens einmal
+    if (refetch) return fetch_waitingtimes(client, cfg, coaster_data);
+    return ok;
+}
+
+// Zweiter Versuch im selben Wake: abgelehnte eingebettete CA -> Bundle,
+// IP aus gespeicherter Lease -> DHCP neu, gespeicherte Adresse nicht
+// erreichbar -> Host live neu auflösen. true, wenn neu verbunden werden kann.
+static bool api_retry_fallback(https_client_t** client, const char* park_id, bool* use_pin)
+{
+    bool pin_rejected = *use_pin && api_tls_pin_rejected(*client);
+    bool connect_err  = !pin_rejected && s_last_err == HTTPS_ERR_CONNECT;
+    bool lease_stale  = connect_err && wifi_conn_lease_recover(wake_cycle_ticks_left(WAKE_PHASE_FETCH));
+    bool addr_stale   = connect_err && s_api_addr_cached;
+    if (!pin_rejected && !lease_stale && !addr_stale) return false;
+
+    if (pin_rejected) *use_pin = false;
+    if (addr_stale) {
+        ESP_LOGW(TAG_API, "Keine Verbindung zu gespeicherter Adresse %s, löse neu auf", s_api_addr);
+        dns_cache_invalidate(API_HOST);
+        api_resolve_host();
+    }
+    https_client_cleanup(*client);
+    *client = api_http_client_create(park_id, 10000, *use_pin);
+    if (!*client) ESP_LOGE(TAG_API, "https_client_init fehlgeschlagen");
+    return *client != NULL;
 }
 
 // -----------------------------------------------------------------------------
-// Public Start-Funktionen
+// Tasks
 // -----------------------------------------------------------------------------
-void start_fetch_waitingtimes_api_task(QueueHandle_t out_queue_coaster,
-                          const char* park_id,
-                          const char* target_ride_name)
+
+typedef struct {
+    QueueHandle_t      q_coaster;
+    QueueHandle_t      q_park;
+    const sd_config_t* cfg;
+    bool               refresh_openingtimes;
+    int32_t            day_key;
+} api_fetch_ctx_t;
+
+static api_fetch_ctx_t s_fetch_ctx;
+
+// Task: API-Scheduler (beide GETs nacheinander über eine Verbindung, Ergebnisse in die Queues).
+// Openingtimes werden nur beim täglichen Refresh oder an einem neuen Tag abgefragt.
+static void api_fetch_task(void* arg)
 {
-    void** pack = calloc(3, sizeof(void*));
-    pack[0] = (void*)out_queue_coaster;
-    pack[1] = (void*)park_id;
-    pack[2] = (void*)target_ride_name;
-    xTaskCreate(waitingtimes_task, "waitingtimes_task", 8192, pack, 5, NULL);
+    const api_fetch_ctx_t* ctx  = (const api_fetch_ctx_t*)arg;
+    QueueHandle_t out_q_coaster = ctx->q_coaster;
+    QueueHandle_t out_q_park    = ctx->q_park;
+    const sd_config_t* cfg      = ctx->cfg;
+    bool          refresh       = ctx->refresh_openingtimes;
+    int32_t       day_key       = ctx->day_key;
+    const char*   park_id       = cfg->park_id;
+
+    if (!wifi_conn_wait_ip(wake_cycle_ticks_left(WAKE_PHASE_WIFI))) {
+        ESP_LOGE(TAG_API, "Timeout: keine Wi-Fi Verbindung (api_fetch)");
+        wake_cycle_signal(WAKE_EVT_API_DONE);
+        task_pool_exit();
+        return;
+    }
+    wake_cycle_mark(WAKE_PHASE_WIFI);
+
+    tls_stats_begin_wake();
+    api_cache_check(cfg);
+    api_resolve_host();
+    // DNS-Server aus gespeicherter Lease antwortet nicht -> DHCP neu, nochmal auflösen
+    if (!s_api_addr[0] && wifi_conn_lease_recover(wake_cycle_ticks_left(WAKE_PHASE_FETCH))) {
+        api_resolve_host();
+    }
+    bool use_pin = api_tls_pin_enabled();
+    https_client_t* client = api_http_client_create(park_id, 10000, use_pin);
+    if (!client) {
+        ESP_LOGE(TAG_API, "https_client_init fehlgeschlagen");
+        wake_cycle_signal(WAKE_EVT_API_DONE);
+        task_pool_exit();
+        return;
+    }
+
+    park_data_t park;
+    bool have_park = true;
+    if (refresh || !park_cache_valid(day_key)) {
+        have_park = fetch_openingtimes(client, day_key, &park);
+        if (!have_park && api_retry_fallback(&client, park_id, &use_pin)) {
+            have_park = fetch_openingtimes(client, day_key, &park);
+        }
+    } else {
+        ESP_LOGI(TAG_API, "Openingtimes für heute im Cache, kein Request");
+        park_from_cache(&park);
+    }
+
+    coaster_data_t coaster_data;
+    bool have_coaster = false;
+    if (client) {
+        have_coaster = fetch_waitingtimes(client, cfg, &coaster_data);
+        if (!have_coaster && api_retry_fallback(&client, park_id, &use_pin)) {
+            have_coaster = fetch_waitingtimes(client, cfg, &coaster_data);
+        }
+    }
+    if (client) https_client_cleanup(client);
+    tls_stats_report();
+
+    // Nachrichten als Wert kopieren, danach gehört nichts mehr diesem Task
+    if (have_park) {
+        if (!out_q_park || xQueueSend(out_q_park, &park, pdMS_TO_TICKS(100)) != pdPASS) {
+            ESP_LOGW(TAG_API, "Park-Queue voll, Wert nicht gesendet.");
+        }
+    }
+
+    if (have_coaster) {
+        if (!out_q_coaster || xQueueSend(out_q_coaster, &coaster_data, pdMS_TO_TICKS(100)) != pdPASS) {
+            ESP_LOGW(TAG_API, "Coaster-Queue voll, Wert nicht gesendet.");
+        }
+    }
+
+    // Auch ohne Daten: print_task soll nicht bis zur Deadline warten
+    wake_cycle_mark(WAKE_PHASE_FETCH);
+    wake_cycle_signal(WAKE_EVT_API_DONE);
+    task_pool_exit();
 }
 
-void start_fetch_openingtimes_api_task(QueueHandle_t out_queue_park,
-                                       const char* park_id)
+// -----------------------------------------------------------------------------
+// Public Start-Funktionen
+// -----------------------------------------------------------------------------
+void start_fetch_api_task(QueueHandle_t out_queue_coaster,
+                          QueueHandle_t out_queue_park,
+                          const sd_config_t* cfg,
+                          bool refresh_openingtimes,
+                          int32_t day_key)
 {
-    void** pack = calloc(2, sizeof(void*));
-    pack[0] = (void*)out_queue_park;
-    pack[1] = (void*)park_id;
-    xTaskCreate(openingtimes_task, "openingtimes_task", 8192, pack, 5, NULL);
+    s_fetch_ctx = (api_fetch_ctx_t){
+        .q_coaster = out_queue_coaster,
+        .q_park = out_queue_park,
+        .cfg = cfg,
+        .refresh_openingtimes = refresh_openingtimes,
+        .day_key = day_key,
+    };
+    task_pool_start(TASK_POOL_API_FETCH, api_fetch_task, &s_fetch_ctx);
 }
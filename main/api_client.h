@@ -2,19 +2,28 @@
 // File: main/api_client.h
 // ==============================================
 #pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "sd_config.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void start_fetch_waitingtimes_api_task(QueueHandle_t out_queue,
-                                       const char* park_id,
-                                       const char* target_ride_name);
+/* Tageskennung für den Openingtimes-Cache (Jahr*1000 + Tag im Jahr), -1 wenn tm_local NULL. */
+int32_t api_day_key(const struct tm* tm_local);
 
-void start_fetch_openingtimes_api_task(QueueHandle_t out_queue_park,
-                                       const char* park_id);
+/* Holt openingtimes und waitingtimes nacheinander über eine Keep-Alive-Verbindung.
+ * Openingtimes kommen aus dem RTC-Cache, solange er für day_key gilt und
+ * refresh_openingtimes nicht gesetzt ist (day_key -1: unbekannt -> immer abfragen). */
+void start_fetch_api_task(QueueHandle_t out_queue_coaster,
+                          QueueHandle_t out_queue_park,
+                          const sd_config_t* cfg,
+                          bool refresh_openingtimes,
+                          int32_t day_key);
 
 #ifdef __cplusplus
 }
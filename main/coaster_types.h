@@ -3,6 +3,8 @@
 // ==============================================
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 #include <strings.h>
 #include <string.h>
 
@@ -44,16 +46,21 @@ static inline const char* coaster_status_to_string(coaster_status_t status)
     }
 }
 
+#define COASTER_NAME_LEN 64
+
+/* Queue-Nachrichten werden als Wert kopiert, ohne Zeiger auf Heap-Objekte */
 typedef struct {
-    int              waitingtime;
+    int16_t          waitingtime;   // Minuten
     coaster_status_t status;
-    char*            name;
+    bool             unchanged;     // Server meldet keinen neuen Stand (304 / gleicher Hash)
+    char             name[COASTER_NAME_LEN];
 } coaster_data_t;
 
 typedef struct {
-    bool  opened_today;
-    char* open_from;
-    char* closed_from;
+    bool   opened_today;
+    time_t open_from;       // 0 wenn nicht bekannt
+    time_t closed_from;
+    bool   unchanged;
 } park_data_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,123 @@
+// ==============================================
+// File: main/dns_cache.c
+// ==============================================
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <ctype.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "lwip/netdb.h"
+#include "lwip/inet.h"
+
+#include "dns_cache.h"
+
+static const char* TAG_DNS = "dns_cache";
+
+#define DNS_CACHE_ENTRIES 4
+
+// lwIP gibt die TTL des Records nicht heraus -> Gültigkeit gibt der Aufrufer pro Host vor
+
+typedef struct {
+    uint32_t host_hash;     // 0 = frei
+    uint32_t addr;          // IPv4, Netzwerk-Byteorder
+    uint32_t ttl_s;
+    time_t   stored_at;
+} dns_entry_t;
+
+static RTC_DATA_ATTR dns_entry_t s_entries[DNS_CACHE_ENTRIES];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t host_hash(const char *host)
+{
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)host; *p; p++) {
+        h ^= (uint8_t)tolower(*p);
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+static bool entry_fresh(const dns_entry_t *e, time_t now)
+{
+    // Uhr zurückgesprungen oder nach SNTP weit voraus -> neu auflösen
+    return e->host_hash && now >= e->stored_at && now - e->stored_at < (time_t)e->ttl_s;
+}
+
+static void store(uint32_t h, uint32_t addr, uint32_t ttl_s, time_t now)
+{
+    taskENTER_CRITICAL(&s_lock);
+    dns_entry_t *slot = NULL;
+    for (int i = 0; i < DNS_CACHE_ENTRIES && !slot; i++) {
+        if (s_entries[i].host_hash == h) slot = &s_entries[i];
+    }
+    for (int i = 0; i < DNS_CACHE_ENTRIES && !slot; i++) {
+        if (!entry_fresh(&s_entries[i], now)) slot = &s_entries[i];
+    }
+    if (!slot) slot = &s_entries[0];
+    slot->host_hash = h;
+    slot->addr      = addr;
+    slot->ttl_s     = ttl_s;
+    slot->stored_at = now;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+bool dns_cache_resolve(const char *host, uint32_t ttl_s, char *ip, size_t ip_len, bool *from_cache)
+{
+    if (from_cache) *from_cache = false;
+    if (!host || !ip || ip_len < DNS_CACHE_IP_LEN) return false;
+
+    uint32_t h = host_hash(host);
+    time_t now = time(NULL);
+    uint32_t addr = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        if (s_entries[i].host_hash == h && entry_fresh(&s_entries[i], now)) {
+            addr = s_entries[i].addr;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (addr) {
+        struct in_addr in = { .s_addr = addr };
+        inet_ntoa_r(in, ip, ip_len);
+        if (from_cache) *from_cache = true;
+        ESP_LOGI(TAG_DNS, "%s -> %s (Cache)", host, ip);
+        return true;
+    }
+
+    const struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    int err = getaddrinfo(host, NULL, &hints, &res);
+    if (err != 0 || !res) {
+        ESP_LOGW(TAG_DNS, "Auflösung von %s fehlgeschlagen (%d)", host, err);
+        if (res) freeaddrinfo(res);
+        return false;
+    }
+    addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(res);
+
+    struct in_addr in = { .s_addr = addr };
+    inet_ntoa_r(in, ip, ip_len);
+    ESP_LOGI(TAG_DNS, "%s -> %s (live)", host, ip);
+
+    if (ttl_s > 0) store(h, addr, ttl_s, now);
+    return true;
+}
+
+void dns_cache_invalidate(const char *host)
+{
+    if (!host) return;
+    uint32_t h = host_hash(host);
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        if (s_entries[i].host_hash == h) s_entries[i].host_hash = 0;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG_DNS, "Cache-Eintrag für %s verworfen", host);
+}
@@ -0,0 +1,31 @@
+// ==============================================
+// File: main/dns_cache.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Kleiner Resolver-Cache in RTC-Memory (übersteht Deep Sleep).
+ * Speichert IPv4-Adressen mit Ablaufzeit; abgelaufene oder ungültig
+ * gemeldete Einträge werden beim nächsten Aufruf live neu aufgelöst.
+ */
+
+#define DNS_CACHE_IP_LEN 16     // "255.255.255.255"
+
+/* Liefert die Adresse von host als String in ip. Kommt sie aus dem Cache,
+ * ist *from_cache true; sonst wurde live aufgelöst und ttl_s Sekunden lang
+ * gespeichert (0 = nicht speichern). false, wenn die Auflösung fehlgeschlagen ist. */
+bool dns_cache_resolve(const char *host, uint32_t ttl_s, char *ip, size_t ip_len, bool *from_cache);
+
+/* Eintrag verwerfen (z.B. Verbindung zur gespeicherten Adresse fehlgeschlagen). */
+void dns_cache_invalidate(const char *host);
+
+#ifdef __cplusplus
+}
+#endif
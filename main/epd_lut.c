@@ -0,0 +1,112 @@
+// ==============================================
+// File: main/epd_lut.c
+// ==============================================
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "epd_lut.h"
+#include "EPD_1in54_V2.h"
+
+static const char* TAG_LUT = "epd_lut";
+
+// Byte-Offsets in der 159-Byte-Tabelle (Gruppen-Timing ab 60, 7 Bytes je Gruppe)
+#define LUT_FULL_FLASH_RP   (60 + 7 * 1 + 6)    // Wiederholungen der Flacker-Gruppe
+#define LUT_PART_DRIVE_TP   (60 + 7 * 0 + 0)    // Frames der einzigen Treiber-Phase
+
+#define TEMP_MIN_C          (-20)               // außerhalb: Messung unplausibel
+#define TEMP_MAX_C          70
+#define TEMP_HYST_16        16                  // 1 °C Hysterese gegen Pendeln an der Grenze
+
+typedef struct {
+    const char *name;
+    int8_t  min_c;          // ab dieser Temperatur
+    uint8_t full_repeat;    // Original: 2 (= drei Durchläufe)
+    uint8_t part_frames;    // Original: 15
+} lut_band_def_t;
+
+static const lut_band_def_t s_bands[EPD_LUT_COUNT] = {
+    [EPD_LUT_FULL]   = { "voll",    -128, 2, 15 },
+    [EPD_LUT_MEDIUM] = { "mittel",  10,   1, 12 },
+    [EPD_LUT_FAST]   = { "schnell", 18,   0, 10 },
+};
+
+typedef struct {
+    time_t  measured;       // 0 = nie gemessen
+    int16_t temp16;         // 1/16 °C
+    uint8_t band;
+} lut_cache_t;
+
+static RTC_DATA_ATTR lut_cache_t s_cache;
+
+static uint8_t s_lut_full[EPD_1IN54_V2_LUT_BYTES];
+static uint8_t s_lut_part[EPD_1IN54_V2_LUT_BYTES];
+
+static epd_lut_band_t band_for(int temp16, epd_lut_band_t prev)
+{
+    epd_lut_band_t band = EPD_LUT_FULL;
+    for (int b = EPD_LUT_COUNT - 1; b > EPD_LUT_FULL; b--) {
+        // Einen Wechsel nach unten erst unterhalb der Grenze minus Hysterese
+        int limit = s_bands[b].min_c * 16 - (b <= (int)prev ? TEMP_HYST_16 : 0);
+        if (temp16 >= limit) {
+            band = (epd_lut_band_t)b;
+            break;
+        }
+    }
+    return band;
+}
+
+static bool cache_stale(time_t now)
+{
+    if (s_cache.measured == 0 || s_cache.band >= EPD_LUT_COUNT) return true;
+    if (now < s_cache.measured) return true;
+    return now - s_cache.measured >= (time_t)CONFIG_EPD_TEMP_CHECK_MIN * 60;
+}
+
+epd_lut_band_t epd_lut_select(time_t now)
+{
+    if (CONFIG_EPD_TEMP_CHECK_MIN == 0) {
+        EPD_1IN54_V2_SetWaveforms(NULL, NULL);
+        return EPD_LUT_FULL;
+    }
+
+    if (cache_stale(now)) {
+        epd_lut_band_t prev = s_cache.measured ? (epd_lut_band_t)s_cache.band : EPD_LUT_FULL;
+        int temp16 = 0;
+        if (EPD_1IN54_V2_ReadTemperature(&temp16) != 0 ||
+            temp16 < TEMP_MIN_C * 16 || temp16 > TEMP_MAX_C * 16) {
+            // Lieber langsam als verwaschen; nächster Refresh misst erneut
+            ESP_LOGW(TAG_LUT, "Paneltemperatur nicht lesbar, verwende Originaltabellen");
+            s_cache.measured = 0;
+            EPD_1IN54_V2_SetWaveforms(NULL, NULL);
+            return EPD_LUT_FULL;
+        }
+        s_cache.measured = now ? now : 1;
+        s_cache.temp16 = (int16_t)temp16;
+        s_cache.band = (uint8_t)band_for(temp16, prev);
+        ESP_LOGI(TAG_LUT, "Paneltemperatur %.1f °C -> Waveform %s",
+                 temp16 / 16.0f, s_bands[s_cache.band].name);
+    }
+
+    epd_lut_band_t band = (epd_lut_band_t)s_cache.band;
+    if (band == EPD_LUT_FULL) {
+        EPD_1IN54_V2_SetWaveforms(NULL, NULL);
+        return band;
+    }
+
+    // Nur die Zeitanteile kürzen, Spannungen und Phasenfolge bleiben wie im Original
+    memcpy(s_lut_full, WF_Full_1IN54, sizeof(s_lut_full));
+    memcpy(s_lut_part, WF_PARTIAL_1IN54_0, sizeof(s_lut_part));
+    s_lut_full[LUT_FULL_FLASH_RP] = s_bands[band].full_repeat;
+    s_lut_part[LUT_PART_DRIVE_TP] = s_bands[band].part_frames;
+    EPD_1IN54_V2_SetWaveforms(s_lut_full, s_lut_part);
+    return band;
+}
+
+const char *epd_lut_to_string(epd_lut_band_t band)
+{
+    return band < EPD_LUT_COUNT ? s_bands[band].name : "?";
+}
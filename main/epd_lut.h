@@ -0,0 +1,35 @@
+// ==============================================
+// File: main/epd_lut.h
+// ==============================================
+#pragma once
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Wählt die Waveforms für Voll- und Teilrefresh nach der Paneltemperatur.
+ * Gemessen wird mit dem internen Sensor des SSD1681 (0x18/0x1B), höchstens
+ * alle CONFIG_EPD_TEMP_CHECK_MIN Minuten; Temperatur und Band liegen
+ * dazwischen im RTC-Memory. Warm reichen deutlich kürzere Waveforms, kalt
+ * bleibt es bei den langen Originaltabellen. CONFIG_EPD_TEMP_CHECK_MIN = 0
+ * schaltet die Auswahl ab.
+ */
+
+typedef enum {
+    EPD_LUT_FULL = 0,       // Originaltabellen (kalt oder Temperatur unbekannt)
+    EPD_LUT_MEDIUM,
+    EPD_LUT_FAST,
+    EPD_LUT_COUNT
+} epd_lut_band_t;
+
+/* Nach DEV_Module_Init, vor EPD_1IN54_V2_Init/Init_Partial: Band bestimmen
+ * (misst bei Bedarf) und die Tabellen an den Treiber übergeben. */
+epd_lut_band_t epd_lut_select(time_t now);
+
+const char *epd_lut_to_string(epd_lut_band_t band);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,154 @@
+// ==============================================
+// File: main/epd_refresh.c
+// ==============================================
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "sdkconfig.h"
+
+#include "epd_refresh.h"
+
+static const char* TAG_EPD = "epd_refresh";
+
+#define REFRESH_MAGIC   0x45504446u     // "EPDF"
+#define FRAME_STRIDE    (EPD_1IN54_V2_WIDTH / 8)
+#define WINDOW_GAP_ROWS 16              // so viele unveränderte Zeilen trennen zwei Fenster
+
+// 5 KB passen nicht mehr ins RTC-Slow-Memory -> Fast-Memory, bleibt im Deep Sleep erhalten
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;               // über frame
+    time_t   last_full;         // Zeitpunkt des letzten Vollrefreshs
+    uint16_t partials;          // Teilrefreshs seit dem letzten Vollrefresh
+    bool     panel_ram;         // Panel-RAM (0x24/0x26) == frame
+    uint8_t  frame[EPD_FRAME_BYTES];
+} refresh_state_t;
+
+static RTC_FAST_ATTR refresh_state_t s_state;
+
+static bool state_valid(void)
+{
+    return s_state.magic == REFRESH_MAGIC &&
+           s_state.crc == esp_rom_crc32_le(0, s_state.frame, sizeof(s_state.frame));
+}
+
+epd_refresh_t epd_refresh_plan(const uint8_t *frame, time_t now)
+{
+    if (!state_valid()) {
+        ESP_LOGI(TAG_EPD, "Kein gespeicherter Frame -> Vollrefresh");
+        return EPD_REFRESH_FULL;
+    }
+    if (memcmp(frame, s_state.frame, sizeof(s_state.frame)) == 0) {
+        return EPD_REFRESH_NONE;
+    }
+    if (s_state.partials >= CONFIG_EPD_PARTIAL_MAX) {
+        ESP_LOGI(TAG_EPD, "%u Teilrefreshs seit dem letzten Vollrefresh -> Vollrefresh", s_state.partials);
+        return EPD_REFRESH_FULL;
+    }
+#if CONFIG_EPD_FULL_REFRESH_MIN > 0
+    // Uhr zurückgesprungen zählt wie eine lange Lücke
+    if (now < s_state.last_full || now - s_state.last_full >= (time_t)CONFIG_EPD_FULL_REFRESH_MIN * 60) {
+        ESP_LOGI(TAG_EPD, "Letzter Vollrefresh vor %lld s -> Vollrefresh", (long long)(now - s_state.last_full));
+        return EPD_REFRESH_FULL;
+    }
+#endif
+    return EPD_REFRESH_PARTIAL;
+}
+
+const uint8_t *epd_refresh_last_frame(void)
+{
+    return state_valid() ? s_state.frame : NULL;
+}
+
+void epd_refresh_commit(const uint8_t *frame, epd_refresh_t done, time_t now)
+{
+    if (done == EPD_REFRESH_NONE) return;
+
+    memcpy(s_state.frame, frame, sizeof(s_state.frame));
+    s_state.crc = esp_rom_crc32_le(0, s_state.frame, sizeof(s_state.frame));
+    s_state.magic = REFRESH_MAGIC;
+    s_state.panel_ram = false;  // erst gültig, wenn das Panel im Deep Sleep versorgt bleibt
+    if (done == EPD_REFRESH_FULL) {
+        s_state.last_full = now;
+        s_state.partials = 0;
+    } else if (s_state.partials < UINT16_MAX) {
+        s_state.partials++;
+    }
+}
+
+static void emit_window(EPD_1IN54_V2_Window *w, int x0, int x1, int y0, int y1)
+{
+    w->Xbyte = x0;
+    w->Wbytes = x1 - x0 + 1;
+    w->Ystart = y0;
+    w->Height = y1 - y0 + 1;
+}
+
+int epd_refresh_dirty_windows(const uint8_t *frame, EPD_1IN54_V2_Window *win, int max)
+{
+    if (!state_valid() || max <= 0) return 0;
+
+    int n = 0;
+    bool open = false;
+    int x0 = 0, x1 = 0, y0 = 0, y1 = 0;
+
+    for (int y = 0; y < EPD_1IN54_V2_HEIGHT; y++) {
+        const uint8_t *a = frame + y * FRAME_STRIDE;
+        const uint8_t *b = s_state.frame + y * FRAME_STRIDE;
+        int first = -1, last = -1;
+        for (int x = 0; x < FRAME_STRIDE; x++) {
+            if (a[x] != b[x]) {
+                if (first < 0) first = x;
+                last = x;
+            }
+        }
+        if (first < 0) continue;
+
+        // Große Lücke: Fenster abschließen; das letzte freie Fenster nimmt den Rest auf
+        if (open && y - y1 > WINDOW_GAP_ROWS && n < max - 1) {
+            emit_window(&win[n++], x0, x1, y0, y1);
+            open = false;
+        }
+        if (!open) {
+            x0 = first; x1 = last; y0 = y;
+            open = true;
+        } else {
+            if (first < x0) x0 = first;
+            if (last > x1) x1 = last;
+        }
+        y1 = y;
+    }
+    if (open) emit_window(&win[n++], x0, x1, y0, y1);
+
+    uint32_t bytes = 0;
+    for (int i = 0; i < n; i++) bytes += (uint32_t)win[i].Wbytes * win[i].Height;
+    ESP_LOGI(TAG_EPD, "%d Fenster, %lu von %u Bytes", n, (unsigned long)bytes, (unsigned)EPD_FRAME_BYTES);
+    return n;
+}
+
+bool epd_refresh_panel_ram_valid(void)
+{
+    return state_valid() && s_state.panel_ram;
+}
+
+void epd_refresh_set_panel_retained(bool retained)
+{
+    s_state.panel_ram = retained && state_valid();
+}
+
+void epd_refresh_invalidate(void)
+{
+    s_state.magic = 0;
+    s_state.panel_ram = false;
+}
+
+const char *epd_refresh_to_string(epd_refresh_t r)
+{
+    switch (r) {
+        case EPD_REFRESH_NONE:    return "keiner";
+        case EPD_REFRESH_PARTIAL: return "Teilrefresh";
+        case EPD_REFRESH_FULL:    return "Vollrefresh";
+        default:                  return "?";
+    }
+}
@@ -0,0 +1,58 @@
+// ==============================================
+// File: main/epd_refresh.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "EPD_1in54_V2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Entscheidet pro Wake, wie das Panel aktualisiert wird. Der zuletzt
+ * angezeigte Frame liegt im RTC-Fast-Memory und wird mit dem neu gerenderten
+ * verglichen: gleich -> Panel bleibt aus, sonst Teilrefresh mit dem alten
+ * Frame als Vergleichsbild. Ein Vollrefresh (gegen Ghosting) kommt nach
+ * CONFIG_EPD_PARTIAL_MAX Teilrefreshs, nach CONFIG_EPD_FULL_REFRESH_MIN
+ * Minuten oder wenn kein gültiger alter Frame vorliegt.
+ */
+
+#define EPD_FRAME_BYTES ((EPD_1IN54_V2_WIDTH / 8) * EPD_1IN54_V2_HEIGHT)
+
+typedef enum {
+    EPD_REFRESH_NONE = 0,       // Frame unverändert, Panel nicht anfassen
+    EPD_REFRESH_PARTIAL,
+    EPD_REFRESH_FULL,
+} epd_refresh_t;
+
+epd_refresh_t epd_refresh_plan(const uint8_t *frame, time_t now);
+
+/* Vorheriger Frame für das Vergleichsbild (RAM 0x26), NULL wenn keiner gültig. */
+const uint8_t *epd_refresh_last_frame(void);
+
+/* Nach erfolgreicher Ausgabe: Frame übernehmen und Zähler fortschreiben. */
+void epd_refresh_commit(const uint8_t *frame, epd_refresh_t done, time_t now);
+
+/* Geänderte Bereiche gegenüber dem gespeicherten Frame als byte-ausgerichtete
+ * Fenster; weit auseinanderliegende Änderungen ergeben getrennte Fenster.
+ * Liefert die Anzahl (höchstens max). */
+int epd_refresh_dirty_windows(const uint8_t *frame, EPD_1IN54_V2_Window *win, int max);
+
+/* Beide RAM-Bänke des Panels enthalten noch den gespeicherten Frame
+ * (Panel blieb seit der letzten Ausgabe versorgt) -> Fenster reichen. */
+bool epd_refresh_panel_ram_valid(void);
+
+/* Vor dem Deep Sleep: Panel bleibt versorgt und behält sein RAM. */
+void epd_refresh_set_panel_retained(bool retained);
+
+/* Panel-Inhalt unbekannt (Fehler bei der Ausgabe): nächster Refresh voll. */
+void epd_refresh_invalidate(void);
+
+const char *epd_refresh_to_string(epd_refresh_t r);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,237 @@
+// ==============================================
+// File: main/http_inflate.c
+// ==============================================
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "rom/miniz.h"
+
+#include "http_inflate.h"
+#include "wake_arena.h"
+
+static const char* TAG_INF = "http_inflate";
+
+// gzip-Header-Flags (RFC 1952)
+#define GZ_FHCRC    0x02
+#define GZ_FEXTRA   0x04
+#define GZ_FNAME    0x08
+#define GZ_FCOMMENT 0x10
+
+enum {
+    GZ_HEADER = 0,  // 10 Byte fester Header
+    GZ_EXTRA_LEN,
+    GZ_EXTRA,
+    GZ_NAME,
+    GZ_COMMENT,
+    GZ_HCRC,
+    GZ_DEFLATE,
+    GZ_TRAILER,     // CRC32 + ISIZE
+    GZ_END,
+};
+
+struct http_inflate {
+    tinfl_decompressor  decomp;
+    uint8_t*            dict;       // Ringpuffer, TINFL_LZ_DICT_SIZE
+    size_t              dict_ofs;
+
+    http_inflate_sink_t sink;
+    void*               ctx;
+
+    uint8_t  state;
+    uint8_t  flags;
+    uint8_t  hdr[10];
+    uint16_t need;                  // restliche Bytes im aktuellen Header-Abschnitt
+    uint16_t have;
+
+    uint32_t crc;
+    size_t   total_in;
+    size_t   total_out;
+    http_inflate_result_t result;
+};
+
+// Decoder samt Dictionary einmal pro Wake: die Arena gibt nur den obersten Block
+// zurück, zwei gzip-Requests hintereinander belegten sonst zweimal 32 KB PSRAM.
+// Statisch im normalen RAM -> nach jedem Deep Sleep wieder leer, wie die Arena.
+static http_inflate_t* s_reuse;
+static bool s_reuse_busy;
+
+http_inflate_t* http_inflate_create(http_inflate_sink_t sink, void* ctx)
+{
+    if (!sink) return NULL;
+
+    http_inflate_t* inf = NULL;
+    if (!s_reuse_busy && s_reuse) {
+        inf = s_reuse;
+        s_reuse_busy = true;
+    } else {
+        // Decoder-Tabellen intern (heißer Pfad), Dictionary im PSRAM
+        inf = wake_arena_calloc(WAKE_ARENA_INTERNAL, 1, sizeof(*inf));
+        if (!inf) return NULL;
+        inf->dict = wake_arena_alloc(WAKE_ARENA_PSRAM, TINFL_LZ_DICT_SIZE);
+        if (!inf->dict) { wake_arena_free(inf); return NULL; }
+        if (!s_reuse) {
+            s_reuse = inf;
+            s_reuse_busy = true;
+        }
+    }
+
+    uint8_t* dict = inf->dict;
+    memset(inf, 0, sizeof(*inf));
+    inf->dict = dict;
+    tinfl_init(&inf->decomp);
+    inf->sink = sink;
+    inf->ctx = ctx;
+    inf->state = GZ_HEADER;
+    inf->need = sizeof(inf->hdr);
+    inf->result = HTTP_INFLATE_CONTINUE;
+    return inf;
+}
+
+void http_inflate_destroy(http_inflate_t* inf)
+{
+    if (!inf) return;
+    if (inf == s_reuse) {
+        s_reuse_busy = false;   // bleibt für den nächsten Request dieses Wakes liegen
+        return;
+    }
+    wake_arena_free(inf->dict);
+    wake_arena_free(inf);
+}
+
+size_t http_inflate_total_in(const http_inflate_t* inf)  { return inf ? inf->total_in : 0; }
+size_t http_inflate_total_out(const http_inflate_t* inf) { return inf ? inf->total_out : 0; }
+
+// Nächsten Header-Abschnitt nach den gesetzten Flags wählen
+static void gz_next_section(http_inflate_t* inf)
+{
+    inf->have = 0;
+    switch (inf->state) {
+    case GZ_HEADER:
+        if (inf->flags & GZ_FEXTRA) { inf->state = GZ_EXTRA_LEN; inf->need = 2; return; }
+        /* fall through - kein FEXTRA */
+    case GZ_EXTRA:
+        if (inf->flags & GZ_FNAME) { inf->state = GZ_NAME; return; }
+        /* fall through - kein FNAME */
+    case GZ_NAME:
+        if (inf->flags & GZ_FCOMMENT) { inf->state = GZ_COMMENT; return; }
+        /* fall through - kein FCOMMENT */
+    case GZ_COMMENT:
+        if (inf->flags & GZ_FHCRC) { inf->state = GZ_HCRC; inf->need = 2; return; }
+        /* fall through - kein FHCRC */
+    default:
+        inf->state = GZ_DEFLATE;
+        return;
+    }
+}
+
+// Verbraucht Header-Bytes; liefert die Anzahl verarbeiteter Bytes
+static size_t gz_header(http_inflate_t* inf, const uint8_t* p, size_t len)
+{
+    size_t i = 0;
+    while (i < len && inf->state < GZ_DEFLATE && inf->result == HTTP_INFLATE_CONTINUE) {
+        uint8_t c = p[i++];
+        switch (inf->state) {
+        case GZ_HEADER:
+            inf->hdr[inf->have++] = c;
+            if (inf->have < sizeof(inf->hdr)) break;
+            if (inf->hdr[0] != 0x1F || inf->hdr[1] != 0x8B || inf->hdr[2] != 8) {
+                ESP_LOGE(TAG_INF, "Kein gzip/deflate-Stream");
+                inf->result = HTTP_INFLATE_ERROR;
+                break;
+            }
+            inf->flags = inf->hdr[3];
+            gz_next_section(inf);
+            break;
+
+        case GZ_EXTRA_LEN:
+            inf->hdr[inf->have++] = c;
+            if (inf->have < 2) break;
+            inf->need = (uint16_t)(inf->hdr[0] | (inf->hdr[1] << 8));
+            inf->state = GZ_EXTRA;
+            inf->have = 0;
+            if (inf->need == 0) gz_next_section(inf);
+            break;
+
+        case GZ_EXTRA:
+        case GZ_HCRC:
+            if (--inf->need == 0) gz_next_section(inf);
+            break;
+
+        case GZ_NAME:
+        case GZ_COMMENT:
+            if (c == 0) gz_next_section(inf);
+            break;
+        }
+    }
+    return i;
+}
+
+static void gz_trailer(http_inflate_t* inf, const uint8_t* p, size_t len)
+{
+    for (size_t i = 0; i < len && inf->have < 8; i++) {
+        inf->hdr[inf->have++] = p[i];
+    }
+    if (inf->have < 8) return;
+
+    uint32_t crc   = (uint32_t)inf->hdr[0] | ((uint32_t)inf->hdr[1] << 8) |
+                     ((uint32_t)inf->hdr[2] << 16) | ((uint32_t)inf->hdr[3] << 24);
+    uint32_t isize = (uint32_t)inf->hdr[4] | ((uint32_t)inf->hdr[5] << 8) |
+                     ((uint32_t)inf->hdr[6] << 16) | ((uint32_t)inf->hdr[7] << 24);
+    if (crc != inf->crc || isize != (uint32_t)inf->total_out) {
+        ESP_LOGW(TAG_INF, "gzip-Trailer passt nicht (crc %08lx/%08lx, size %lu/%lu)",
+                 (unsigned long)crc, (unsigned long)inf->crc,
+                 (unsigned long)isize, (unsigned long)inf->total_out);
+    }
+    inf->state = GZ_END;
+    inf->result = HTTP_INFLATE_DONE;
+}
+
+http_inflate_result_t http_inflate_feed(http_inflate_t* inf, const char* data, size_t len)
+{
+    if (!inf) return HTTP_INFLATE_ERROR;
+    if (inf->result != HTTP_INFLATE_CONTINUE || !data) return inf->result;
+
+    const uint8_t* p = (const uint8_t*)data;
+    inf->total_in += len;
+
+    size_t n = gz_header(inf, p, len);
+    p += n; len -= n;
+
+    while (inf->state == GZ_DEFLATE && inf->result == HTTP_INFLATE_CONTINUE) {
+        size_t in_sz  = len;
+        size_t out_sz = TINFL_LZ_DICT_SIZE - inf->dict_ofs;
+        tinfl_status st = tinfl_decompress(&inf->decomp, p, &in_sz,
+                                           inf->dict, inf->dict + inf->dict_ofs, &out_sz,
+                                           TINFL_FLAG_HAS_MORE_INPUT);
+        p += in_sz; len -= in_sz;
+
+        if (out_sz > 0) {
+            const uint8_t* out = inf->dict + inf->dict_ofs;
+            inf->crc = esp_rom_crc32_le(inf->crc, out, out_sz);
+            inf->total_out += out_sz;
+            inf->dict_ofs = (inf->dict_ofs + out_sz) & (TINFL_LZ_DICT_SIZE - 1);
+            if (!inf->sink((const char*)out, out_sz, inf->ctx)) {
+                inf->result = HTTP_INFLATE_STOP;
+                break;
+            }
+        }
+
+        if (st < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG_INF, "Deflate-Fehler %d nach %u Bytes", (int)st, (unsigned)inf->total_in);
+            inf->result = HTTP_INFLATE_ERROR;
+        } else if (st == TINFL_STATUS_DONE) {
+            inf->state = GZ_TRAILER;
+            inf->have = 0;
+        } else if (st == TINFL_STATUS_NEEDS_MORE_INPUT || (in_sz == 0 && out_sz == 0)) {
+            break;
+        }
+        // TINFL_STATUS_HAS_MORE_OUTPUT: Fenster ist voll, weiter entpacken
+    }
+
+    if (inf->state == GZ_TRAILER && inf->result == HTTP_INFLATE_CONTINUE) {
+        gz_trailer(inf, p, len);
+    }
+    return inf->result;
+}
@@ -0,0 +1,44 @@
+// ==============================================
+// File: main/http_inflate.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming-Entpacker für gzip-Antworten (Content-Encoding: gzip).
+ * Nutzt tinfl aus dem ROM, das 32 KB Fenster liegt bevorzugt im PSRAM.
+ * Entpackte Daten gehen chunkweise an die Senke, der Body wird nie
+ * vollständig im RAM gehalten. Decoder und Fenster werden innerhalb eines
+ * Wakes wiederverwendet (ein Satz für alle Requests nacheinander).
+ */
+
+typedef struct http_inflate http_inflate_t;
+
+// Liefert false, wenn keine weiteren Daten gebraucht werden (Abbruch)
+typedef bool (*http_inflate_sink_t)(const char* data, size_t len, void* ctx);
+
+typedef enum {
+    HTTP_INFLATE_CONTINUE = 0,  // weiter füttern
+    HTTP_INFLATE_STOP,          // Senke hat abgebrochen
+    HTTP_INFLATE_DONE,          // gzip-Stream vollständig
+    HTTP_INFLATE_ERROR,         // kein gültiges gzip / Deflate-Fehler
+} http_inflate_result_t;
+
+http_inflate_t* http_inflate_create(http_inflate_sink_t sink, void* ctx);
+void http_inflate_destroy(http_inflate_t* inf);
+
+/* Füttert komprimierte Daten. Nach STOP/DONE/ERROR werden weitere Daten ignoriert. */
+http_inflate_result_t http_inflate_feed(http_inflate_t* inf, const char* data, size_t len);
+
+size_t http_inflate_total_in(const http_inflate_t* inf);
+size_t http_inflate_total_out(const http_inflate_t* inf);
+
+#ifdef __cplusplus
+}
+#endif
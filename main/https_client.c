@@ -0,0 +1,473 @@
+// ==============================================
+// File: main/https_client.c
+// ==============================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include "esp_crt_bundle.h"
+#include "mbedtls/ssl.h"
+#include "http_parser.h"
+
+#include "https_client.h"
+
+static const char* TAG_HTTPS = "https_client";
+
+#define HTTPS_MAX_HEADERS   8
+#define HTTPS_HDR_KEY_MAX   24
+#define HTTPS_HDR_VAL_MAX   80
+#define HTTPS_RESP_KEY_MAX  32
+#define HTTPS_RESP_VAL_MAX  128
+#define HTTPS_REQ_MAX       768
+#define HTTPS_RX_CHUNK      512
+#define HTTPS_HOST_MAX      64
+#define HTTPS_ADDR_MAX      16
+
+// -----------------------------------------------------------------------------
+// TLS-Session über Deep Sleep (RTC-Memory)
+// -----------------------------------------------------------------------------
+// Gespeichert wird das mbedtls_ssl_session_save-Format: Master Secret, Ticket
+// und vom Server-Zertifikat nur der Hash (MBEDTLS_SSL_KEEP_PEER_CERTIFICATE
+// aus, das Leaf allein wären über 1 KB). Größer als HTTPS_SESSION_MAX wird es
+// nur mit ungewöhnlich langem Ticket; dann wird nichts gespeichert und der
+// nächste Wake macht einen vollen Handshake. Eine wiederaufgenommene Session
+// wurde beim vollen Handshake geprüft, gegen welche Vertrauensbasis auch
+// immer der damals lief (eingebettete CA oder Bundle).
+#if !CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+#error "https_client braucht CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS (esp_tls_get_client_session)"
+#endif
+#if CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE
+#error "CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE ausschalten: mit Zertifikat passt die Session nicht ins RTC-Memory"
+#endif
+
+#define HTTPS_SESSION_MAGIC 0x53455331u  // "SES1"
+#define HTTPS_SESSION_MAX   512
+#define HTTPS_MASTER_LEN    48
+
+typedef struct {
+    uint32_t magic;
+    uint32_t host_hash;         // host + port, zu dem die Session gehört
+    uint16_t len;
+    uint8_t  blob[HTTPS_SESSION_MAX];
+} https_session_store_t;
+
+static RTC_DATA_ATTR https_session_store_t s_session;
+
+typedef struct {
+    char key[HTTPS_HDR_KEY_MAX];
+    char value[HTTPS_HDR_VAL_MAX];
+} https_header_t;
+
+struct https_client {
+    char             host[HTTPS_HOST_MAX];
+    char             addr[HTTPS_ADDR_MAX];  // leer: host auflösen
+    uint16_t         port;
+    int              timeout_ms;
+    const char      *cert_pem;  // eingebettet, lebt so lange wie die Firmware
+    size_t           cert_len;
+    https_event_cb_t event_handler;
+    void            *user_data;
+    https_header_t   headers[HTTPS_MAX_HEADERS];
+
+    esp_tls_t       *tls;       // NULL: nicht verbunden
+    int              last_tls_code;
+    int              last_verify_flags;
+
+    // laufende Antwort
+    http_parser      parser;
+    https_body_cb_t  on_body;
+    void            *body_ctx;
+    bool             msg_done;
+    bool             aborted;
+    bool             hdr_in_value;
+    char             hdr_key[HTTPS_RESP_KEY_MAX];
+    char             hdr_val[HTTPS_RESP_VAL_MAX];
+    char             req[HTTPS_REQ_MAX];
+    char             rx[HTTPS_RX_CHUNK];
+};
+
+static uint32_t session_host_hash(const https_client_t *c)
+{
+    uint32_t h = 2166136261u;
+    for (const char *p = c->host; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    h ^= c->port;
+    h *= 16777619u;
+    return h;
+}
+
+// Gespeicherte Session als cfg.client_session; NULL, wenn keine passt.
+// master: deren Master Secret, um die Wiederaufnahme danach zu erkennen.
+static esp_tls_client_session_t *session_load(const https_client_t *c, unsigned char *master)
+{
+    if (s_session.magic != HTTPS_SESSION_MAGIC || s_session.host_hash != session_host_hash(c) ||
+        s_session.len == 0 || s_session.len > sizeof(s_session.blob)) {
+        return NULL;
+    }
+
+    esp_tls_client_session_t *sess = calloc(1, sizeof(*sess));
+    if (!sess) return NULL;
+    mbedtls_ssl_session_init(&sess->saved_session);
+    int ret = mbedtls_ssl_session_load(&sess->saved_session, s_session.blob, s_session.len);
+    if (ret != 0) {
+        // z.B. nach Firmware-Update mit anderer mbedTLS-Konfiguration
+        ESP_LOGW(TAG_HTTPS, "Gespeicherte TLS-Session unbrauchbar (-0x%04x), verworfen", (unsigned)-ret);
+        s_session.magic = 0;
+        esp_tls_free_client_session(sess);
+        return NULL;
+    }
+    memcpy(master, sess->saved_session.MBEDTLS_PRIVATE(master), HTTPS_MASTER_LEN);
+    return sess;
+}
+
+// Session nach dem Handshake sichern; true, wenn der Server die angebotene
+// Session übernommen hat. Die Session-ID taugt dafür nicht: mit Ticket
+// erzeugt mbedTLS für jeden ClientHello eine zufällige ID, die der Server
+// bei Annahme zurückschickt. Gleiches Master Secret heißt dagegen sicher,
+// dass kein Schlüsselaustausch stattgefunden hat.
+static bool session_store(https_client_t *c, const unsigned char *offered_master)
+{
+    esp_tls_client_session_t *sess = esp_tls_get_client_session(c->tls);
+    if (!sess) {
+        ESP_LOGW(TAG_HTTPS, "TLS-Session nicht verfügbar, nicht gespeichert");
+        return false;
+    }
+    bool resumed = offered_master &&
+                   memcmp(sess->saved_session.MBEDTLS_PRIVATE(master), offered_master, HTTPS_MASTER_LEN) == 0;
+
+    size_t len = 0;
+    s_session.magic = 0;    // Puffer wird auch bei zu kleinem Platz teilweise beschrieben
+    int ret = mbedtls_ssl_session_save(&sess->saved_session, s_session.blob, sizeof(s_session.blob), &len);
+    if (ret == 0) {
+        s_session.host_hash = session_host_hash(c);
+        s_session.len = (uint16_t)len;
+        s_session.magic = HTTPS_SESSION_MAGIC;
+    } else if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        ESP_LOGW(TAG_HTTPS, "TLS-Session braucht %u Bytes, nur %u im RTC-Memory, nicht gespeichert",
+                 (unsigned)len, (unsigned)sizeof(s_session.blob));
+    } else {
+        ESP_LOGW(TAG_HTTPS, "TLS-Session nicht gespeichert (-0x%04x)", (unsigned)-ret);
+    }
+    esp_tls_free_client_session(sess);
+    return resumed;
+}
+
+// -----------------------------------------------------------------------------
+// Verbindung (esp-tls)
+// -----------------------------------------------------------------------------
+void https_client_close(https_client_t *c)
+{
+    if (!c || !c->tls) return;
+    esp_tls_conn_destroy(c->tls);
+    c->tls = NULL;
+}
+
+// Ursache eines gescheiterten Verbindungsaufbaus. Ein mbedTLS-Code heißt, dass
+// TCP stand und der Handshake scheiterte; ohne ist es DNS, Socket oder TCP.
+static esp_err_t connect_error(https_client_t *c)
+{
+    esp_tls_error_handle_t eh = NULL;
+    esp_err_t last = ESP_FAIL;
+    int tls_code = 0;
+    int tls_flags = 0;
+    if (esp_tls_get_error_handle(c->tls, &eh) == ESP_OK && eh) {
+        last = esp_tls_get_and_clear_last_error(eh, &tls_code, &tls_flags);
+    }
+    ESP_LOGE(TAG_HTTPS, "Verbindung zu %s fehlgeschlagen: %s (esp-tls 0x%x, verify flags 0x%x)",
+             c->addr[0] ? c->addr : c->host, esp_err_to_name(last), tls_code, tls_flags);
+
+    c->last_tls_code = tls_code;
+    // -1: der Handshake scheiterte, bevor die Kette geprüft wurde
+    c->last_verify_flags = (tls_flags != -1) ? tls_flags : 0;
+    return tls_code ? HTTPS_ERR_TLS : HTTPS_ERR_CONNECT;
+}
+
+static esp_err_t https_connect(https_client_t *c)
+{
+    unsigned char master[HTTPS_MASTER_LEN];
+    esp_tls_client_session_t *offer = session_load(c, master);
+    bool offered = offer != NULL;
+
+    // Verbindung per IP: SNI und Zertifikatsprüfung laufen trotzdem gegen host
+    const char *target = c->addr[0] ? c->addr : c->host;
+    esp_tls_cfg_t cfg = {
+        .timeout_ms     = c->timeout_ms,
+        .client_session = offer,
+        .common_name    = c->addr[0] ? c->host : NULL,
+    };
+    if (c->cert_pem) {
+        cfg.cacert_buf   = (const unsigned char*)c->cert_pem;
+        cfg.cacert_bytes = c->cert_len;
+    } else {
+        cfg.crt_bundle_attach = esp_crt_bundle_attach;
+    }
+
+    c->tls = esp_tls_init();
+    if (!c->tls) {
+        if (offer) esp_tls_free_client_session(offer);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(target, (int)strlen(target), c->port, &cfg, c->tls);
+    if (offer) esp_tls_free_client_session(offer);     // mbedtls_ssl_set_session hat sie kopiert
+    if (ret != 1) {
+        esp_err_t err = connect_error(c);
+        https_client_close(c);
+        return err;
+    }
+
+    https_tls_info_t info = {
+        .offered    = offered,
+        .resumed    = session_store(c, offered ? master : NULL),
+        .connect_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000),
+    };
+    if (c->event_handler) {
+        c->event_handler(&(https_event_t){ .id = HTTPS_EVENT_CONNECTED, .tls = &info, .user_data = c->user_data });
+    }
+    return ESP_OK;
+}
+
+// -----------------------------------------------------------------------------
+// HTTP/1.1
+// -----------------------------------------------------------------------------
+static void emit_header(https_client_t *c)
+{
+    if (c->hdr_key[0] && c->event_handler) {
+        c->event_handler(&(https_event_t){
+            .id = HTTPS_EVENT_HEADER, .key = c->hdr_key, .value = c->hdr_val, .user_data = c->user_data });
+    }
+    c->hdr_key[0] = '\0';
+    c->hdr_val[0] = '\0';
+    c->hdr_in_value = false;
+}
+
+// Feld und Wert können über mehrere Empfangspuffer verteilt ankommen
+static void append_piece(char *dst, size_t cap, const char *at, size_t len)
+{
+    size_t cur = strlen(dst);
+    if (cur + 1 >= cap) return;
+    if (len > cap - 1 - cur) len = cap - 1 - cur;
+    memcpy(dst + cur, at, len);
+    dst[cur + len] = '\0';
+}
+
+static int on_header_field(http_parser *p, const char *at, size_t len)
+{
+    https_client_t *c = (https_client_t*)p->data;
+    if (c->hdr_in_value) emit_header(c);
+    append_piece(c->hdr_key, sizeof(c->hdr_key), at, len);
+    return 0;
+}
+
+static int on_header_value(http_parser *p, const char *at, size_t len)
+{
+    https_client_t *c = (https_client_t*)p->data;
+    c->hdr_in_value = true;
+    append_piece(c->hdr_val, sizeof(c->hdr_val), at, len);
+    return 0;
+}
+
+static int on_headers_complete(http_parser *p)
+{
+    https_client_t *c = (https_client_t*)p->data;
+    emit_header(c);
+    return 0;
+}
+
+static int on_body(http_parser *p, const char *at, size_t len)
+{
+    https_client_t *c = (https_client_t*)p->data;
+    if (c->on_body && !c->on_body(p->status_code, at, len, c->body_ctx)) {
+        c->aborted = true;
+        return -1;
+    }
+    return 0;
+}
+
+static int on_message_complete(http_parser *p)
+{
+    https_client_t *c = (https_client_t*)p->data;
+    c->msg_done = true;
+    return 0;
+}
+
+static const http_parser_settings s_parser_settings = {
+    .on_header_field     = on_header_field,
+    .on_header_value     = on_header_value,
+    .on_headers_complete = on_headers_complete,
+    .on_body             = on_body,
+    .on_message_complete = on_message_complete,
+};
+
+static int build_request(https_client_t *c, const char *path)
+{
+    int n = snprintf(c->req, sizeof(c->req),
+                     "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP32 HTTP Client/1.0\r\n", path, c->host);
+    for (int i = 0; i < HTTPS_MAX_HEADERS && n > 0 && n < (int)sizeof(c->req); i++) {
+        if (!c->headers[i].key[0]) continue;
+        n += snprintf(c->req + n, sizeof(c->req) - n, "%s: %s\r\n", c->headers[i].key, c->headers[i].value);
+    }
+    if (n > 0 && n < (int)sizeof(c->req)) n += snprintf(c->req + n, sizeof(c->req) - n, "\r\n");
+    return (n > 0 && n < (int)sizeof(c->req)) ? n : -1;
+}
+
+static esp_err_t send_all(https_client_t *c, const char *buf, int len)
+{
+    while (len > 0) {
+        ssize_t n = esp_tls_conn_write(c->tls, buf, (size_t)len);
+        if (n <= 0) return HTTPS_ERR_IO;    // auch WANT_WRITE: Sende-Timeout des Sockets
+        buf += n;
+        len -= (int)n;
+    }
+    return ESP_OK;
+}
+
+// Ein Request über die offene Verbindung. *got_response: mindestens ein Byte gelesen
+static esp_err_t request_once(https_client_t *c, int req_len, int *status, bool *got_response)
+{
+    *got_response = false;
+    esp_err_t err = send_all(c, c->req, req_len);
+    if (err != ESP_OK) return err;
+
+    http_parser_init(&c->parser, HTTP_RESPONSE);
+    c->parser.data = c;
+    c->msg_done = false;
+    c->aborted = false;
+    c->hdr_in_value = false;
+    c->hdr_key[0] = '\0';
+    c->hdr_val[0] = '\0';
+
+    while (!c->msg_done) {
+        ssize_t n = esp_tls_conn_read(c->tls, c->rx, sizeof(c->rx));
+        if (n == 0) {
+            // Verbindungsende: beendet Antworten ohne Längenangabe
+            if (*got_response) http_parser_execute(&c->parser, &s_parser_settings, NULL, 0);
+            break;
+        }
+        if (n < 0) {
+            // WANT_READ: Empfangs-Timeout des Sockets (timeout_ms)
+            ESP_LOGE(TAG_HTTPS, "Lesen fehlgeschlagen (-0x%04x)", (unsigned)-n);
+            return HTTPS_ERR_IO;
+        }
+        *got_response = true;
+        size_t used = http_parser_execute(&c->parser, &s_parser_settings, c->rx, (size_t)n);
+        if (c->parser.status_code) *status = c->parser.status_code;
+        if (c->aborted) return ESP_OK;
+        if (HTTP_PARSER_ERRNO(&c->parser) != HPE_OK || used != (size_t)n) {
+            ESP_LOGE(TAG_HTTPS, "Antwort nicht lesbar: %s", http_errno_name(HTTP_PARSER_ERRNO(&c->parser)));
+            return HTTPS_ERR_PROTO;
+        }
+    }
+    return c->msg_done ? ESP_OK : HTTPS_ERR_IO;
+}
+
+esp_err_t https_client_get(https_client_t *c, const char *path, https_body_cb_t on_body, void *ctx, int *status)
+{
+    if (!c || !path || !status) return ESP_ERR_INVALID_ARG;
+    *status = -1;
+
+    int req_len = build_request(c, path);
+    if (req_len < 0) {
+        ESP_LOGE(TAG_HTTPS, "Request-Header zu lang für %s", path);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    c->on_body = on_body;
+    c->body_ctx = ctx;
+
+    // Eine per Keep-Alive offene Verbindung kann der Server inzwischen geschlossen
+    // haben; ohne gelesene Antwort dann einmal neu verbinden (mit Session).
+    esp_err_t err = ESP_OK;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = c->tls != NULL;
+        if (!reused) {
+            err = https_connect(c);
+            if (err != ESP_OK) break;
+        }
+        bool got_response = false;
+        err = request_once(c, req_len, status, &got_response);
+        if (err == ESP_OK || got_response || !reused) break;
+        ESP_LOGI(TAG_HTTPS, "Wiederverwendete Verbindung geschlossen, verbinde neu");
+        https_client_close(c);
+    }
+
+    if (err != ESP_OK || c->aborted || !http_should_keep_alive(&c->parser)) {
+        https_client_close(c);
+    }
+    c->on_body = NULL;
+    c->body_ctx = NULL;
+    return err;
+}
+
+// -----------------------------------------------------------------------------
+// Lebenszyklus
+// -----------------------------------------------------------------------------
+esp_err_t https_client_set_header(https_client_t *c, const char *key, const char *value)
+{
+    if (!c || !key) return ESP_ERR_INVALID_ARG;
+    https_header_t *slot = NULL;
+    for (int i = 0; i < HTTPS_MAX_HEADERS; i++) {
+        if (strcasecmp(c->headers[i].key, key) == 0) { slot = &c->headers[i]; break; }
+        if (!slot && !c->headers[i].key[0]) slot = &c->headers[i];
+    }
+    if (!value) {
+        if (slot && strcasecmp(slot->key, key) == 0) memset(slot, 0, sizeof(*slot));
+        return ESP_OK;
+    }
+    if (!slot) return ESP_ERR_NO_MEM;
+    if (strlen(key) >= sizeof(slot->key) || strlen(value) >= sizeof(slot->value)) return ESP_ERR_INVALID_SIZE;
+    strlcpy(slot->key, key, sizeof(slot->key));
+    strlcpy(slot->value, value, sizeof(slot->value));
+    return ESP_OK;
+}
+
+https_client_t *https_client_init(const https_client_config_t *cfg)
+{
+    if (!cfg || !cfg->host || strlen(cfg->host) >= HTTPS_HOST_MAX) return NULL;
+    if (cfg->addr && strlen(cfg->addr) >= HTTPS_ADDR_MAX) return NULL;
+
+    https_client_t *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    strlcpy(c->host, cfg->host, sizeof(c->host));
+    if (cfg->addr) strlcpy(c->addr, cfg->addr, sizeof(c->addr));
+    c->port          = cfg->port ? cfg->port : 443;
+    c->timeout_ms    = cfg->timeout_ms > 0 ? cfg->timeout_ms : 10000;
+    c->cert_pem      = cfg->cert_pem;
+    c->cert_len      = cfg->cert_len;
+    c->event_handler = cfg->event_handler;
+    c->user_data     = cfg->user_data;
+    return c;
+}
+
+void https_client_cleanup(https_client_t *c)
+{
+    if (!c) return;
+    https_client_close(c);
+    free(c);
+}
+
+void https_client_get_and_clear_last_tls_error(https_client_t *c, int *tls_code, int *verify_flags)
+{
+    if (!c) return;
+    if (tls_code) *tls_code = c->last_tls_code;
+    if (verify_flags) *verify_flags = c->last_verify_flags;
+    c->last_tls_code = 0;
+    c->last_verify_flags = 0;
+}
+
+const char *https_client_err_name(esp_err_t err)
+{
+    switch (err) {
+        case HTTPS_ERR_CONNECT: return "HTTPS_ERR_CONNECT";
+        case HTTPS_ERR_TLS:     return "HTTPS_ERR_TLS";
+        case HTTPS_ERR_IO:      return "HTTPS_ERR_IO";
+        case HTTPS_ERR_PROTO:   return "HTTPS_ERR_PROTO";
+        default:                return esp_err_to_name(err);
+    }
+}
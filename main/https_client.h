@@ -0,0 +1,89 @@
+// ==============================================
+// File: main/https_client.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Schlanker HTTP/1.1-Client (GET, Keep-Alive) auf esp-tls.
+ * Statt esp_http_client, weil dort die TLS-Session nicht zugänglich ist:
+ * Hier wird sie nach jedem Handshake mit esp_tls_get_client_session geholt,
+ * ohne Peer-Zertifikat in RTC-Memory abgelegt und beim nächsten
+ * Verbindungsaufbau (auch nach Deep Sleep) als cfg.client_session wieder
+ * angeboten. Ob der Server sie übernommen hat, meldet HTTPS_EVENT_CONNECTED.
+ */
+
+#define HTTPS_ERR_BASE      0x7100
+#define HTTPS_ERR_CONNECT   (HTTPS_ERR_BASE + 1)    // DNS oder TCP
+#define HTTPS_ERR_TLS       (HTTPS_ERR_BASE + 2)    // Handshake, auch Zertifikat abgelehnt
+#define HTTPS_ERR_IO        (HTTPS_ERR_BASE + 3)    // Senden/Empfangen abgebrochen
+#define HTTPS_ERR_PROTO     (HTTPS_ERR_BASE + 4)    // Antwort nicht lesbar
+
+typedef struct https_client https_client_t;
+
+typedef struct {
+    bool     resumed;           // Server hat die gespeicherte Session übernommen
+    bool     offered;           // eine gespeicherte Session wurde angeboten
+    uint32_t connect_ms;        // TCP + Handshake
+} https_tls_info_t;
+
+typedef enum {
+    HTTPS_EVENT_CONNECTED,      // tls gesetzt
+    HTTPS_EVENT_HEADER,         // key/value gesetzt
+} https_event_id_t;
+
+typedef struct {
+    https_event_id_t        id;
+    const char             *key;
+    const char             *value;
+    const https_tls_info_t *tls;
+    void                   *user_data;
+} https_event_t;
+
+typedef void (*https_event_cb_t)(const https_event_t *evt);
+
+/* Body-Daten der laufenden Antwort; false bricht ab und schließt die Verbindung. */
+typedef bool (*https_body_cb_t)(int status, const char *data, size_t len, void *ctx);
+
+typedef struct {
+    const char      *host;          // TLS-Name (SNI, Zertifikat) und Host-Header
+    const char      *addr;          // optional: IPv4 statt host für den Verbindungsaufbau
+    uint16_t         port;          // 0 = 443
+    int              timeout_ms;
+    const char      *cert_pem;      // eingebettete CA; NULL = Zertifikats-Bundle
+    size_t           cert_len;      // inkl. abschließender 0
+    https_event_cb_t event_handler;
+    void            *user_data;
+} https_client_config_t;
+
+https_client_t *https_client_init(const https_client_config_t *cfg);
+void https_client_cleanup(https_client_t *c);
+
+/* Fester Request-Header; value NULL entfernt ihn. */
+esp_err_t https_client_set_header(https_client_t *c, const char *key, const char *value);
+
+/* GET path über die offene Verbindung (sonst neu verbinden). Schließt der Server
+ * eine wiederverwendete Verbindung vor der Antwort, wird einmal neu verbunden.
+ * *status ist -1, solange keine Statuszeile gelesen wurde. */
+esp_err_t https_client_get(https_client_t *c, const char *path, https_body_cb_t on_body, void *ctx, int *status);
+
+/* Verbindung schließen (z.B. nach Abbruch); der nächste GET verbindet neu. */
+void https_client_close(https_client_t *c);
+
+/* esp-tls-Fehlercode und Zertifikats-Prüfflags des letzten gescheiterten
+ * Verbindungsaufbaus, danach 0. Die Flags sind nur gesetzt, wenn die Kette
+ * tatsächlich geprüft und abgelehnt wurde. */
+void https_client_get_and_clear_last_tls_error(https_client_t *c, int *tls_code, int *verify_flags);
+
+const char *https_client_err_name(esp_err_t err);
+
+#ifdef __cplusplus
+}
+#endif
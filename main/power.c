@@ -0,0 +1,227 @@
+// ==============================================
+// File: main/power.c
+// ==============================================
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_gpio.h"
+#include "esp_timer.h"
+
+#include "power.h"
+#include "DEV_Config.h"
+#include "sd_config.h"
+
+static const char* TAG_PWR = "power";
+
+#define MAX_SLEEP_HOOKS 4
+#define SIG_INPUT       (-1)    // vom versorgten Gerät getrieben, nur Eingang
+
+typedef struct {
+    gpio_num_t pin;
+    int8_t     level;           // Pegel im Deep Sleep bei gehaltener Schiene
+} rail_signal_t;
+
+typedef struct {
+    const char          *name;
+    gpio_num_t           en_pin;
+    uint16_t             settle_ms;
+    const rail_signal_t *signals;
+    uint8_t              n_signals;
+} rail_def_t;
+
+// RST/CS inaktiv, Takt/Daten/DC fest auf low statt offen
+static const rail_signal_t s_epd_signals[] = {
+    { EPD_RST_PIN,  1 },
+    { EPD_CS_PIN,   1 },
+    { EPD_SCK_PIN,  0 },
+    { EPD_MOSI_PIN, 0 },
+    { EPD_DC_PIN,   0 },
+    { EPD_BUSY_PIN, SIG_INPUT },
+};
+
+// Karte wird nie über den Deep Sleep versorgt. Card Detect schwebt im Deep Sleep
+// (Pull-up bei gesteckter Karte kostet ~70 µA); sd_card_present lässt ihn einschwingen
+static const rail_signal_t s_sd_signals[] = {
+    { SD_PIN_CLK, SIG_INPUT },
+    { SD_PIN_CMD, SIG_INPUT },
+    { SD_PIN_D0,  SIG_INPUT },
+    { SD_PIN_D1,  SIG_INPUT },
+    { SD_PIN_D2,  SIG_INPUT },
+    { SD_PIN_D3,  SIG_INPUT },
+    { SD_CD_GPIO, SIG_INPUT },
+};
+
+static const rail_def_t s_rails[POWER_RAIL_COUNT] = {
+    [POWER_RAIL_EPD] = { "EPD", EPD_PWR_PIN,    100, s_epd_signals, sizeof(s_epd_signals) / sizeof(s_epd_signals[0]) },
+    [POWER_RAIL_SD]  = { "SD",  SD_PWR_EN_GPIO, 10,  s_sd_signals,  sizeof(s_sd_signals) / sizeof(s_sd_signals[0]) },
+};
+
+typedef struct {
+    uint8_t  refs;
+    bool     on;
+    bool     retain;
+    int64_t  on_since_us;
+    uint32_t on_ms;             // in diesem Wake
+} rail_state_t;
+
+// Über Deep Sleep: welche Schienen gehalten sind, Einschaltzeit seit Kaltstart
+typedef struct {
+    uint8_t  held_mask;
+    uint32_t on_ms_total[POWER_RAIL_COUNT];
+    uint32_t held_sleeps[POWER_RAIL_COUNT];
+} power_rtc_t;
+
+static RTC_DATA_ATTR power_rtc_t s_rtc;
+
+static rail_state_t s_state[POWER_RAIL_COUNT];
+static power_sleep_hook_t s_hooks[MAX_SLEEP_HOOKS];
+static int s_hook_count;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void rail_switch(power_rail_t rail, bool on)
+{
+    rail_state_t *st = &s_state[rail];
+    gpio_set_level(s_rails[rail].en_pin, on ? 1 : 0);
+    int64_t now = esp_timer_get_time();
+    if (on) {
+        st->on_since_us = now;
+    } else if (st->on) {
+        st->on_ms += (uint32_t)((now - st->on_since_us) / 1000);
+    }
+    st->on = on;
+}
+
+// Signal ohne Treiber und Pull, im Deep Sleep gehalten
+static void signal_isolate(gpio_num_t pin)
+{
+    esp_rom_gpio_pad_select_gpio(pin);
+    gpio_set_direction(pin, GPIO_MODE_DISABLE);
+    gpio_set_pull_mode(pin, GPIO_FLOATING);
+    gpio_hold_en(pin);
+}
+
+// SPI-Pins hängen am IOMUX: erst auf GPIO zurückschalten, sonst greift der Pegel nicht
+static void signal_hold(const rail_signal_t *sig)
+{
+    esp_rom_gpio_pad_select_gpio(sig->pin);
+    if (sig->level == SIG_INPUT) {
+        gpio_set_direction(sig->pin, GPIO_MODE_INPUT);
+        gpio_set_pull_mode(sig->pin, GPIO_FLOATING);
+    } else {
+        gpio_set_level(sig->pin, sig->level);
+        gpio_set_direction(sig->pin, GPIO_MODE_OUTPUT);
+    }
+    gpio_hold_en(sig->pin);
+}
+
+void power_init(bool cold_boot)
+{
+    if (cold_boot) s_rtc.held_mask = 0;
+
+    for (int r = 0; r < POWER_RAIL_COUNT; r++) {
+        const rail_def_t *def = &s_rails[r];
+        bool held = s_rtc.held_mask & (1u << r);
+
+        // Erst denselben Pegel treiben, dann Hold lösen -> kein Einbruch der Versorgung
+        gpio_set_level(def->en_pin, held ? 1 : 0);
+        gpio_set_direction(def->en_pin, GPIO_MODE_OUTPUT);
+        gpio_hold_dis(def->en_pin);
+
+        for (int i = 0; i < def->n_signals; i++) {
+            const rail_signal_t *sig = &def->signals[i];
+            if (held && sig->level != SIG_INPUT) {
+                gpio_set_level(sig->pin, sig->level);
+                gpio_set_direction(sig->pin, GPIO_MODE_OUTPUT);
+            }
+            gpio_hold_dis(sig->pin);
+        }
+
+        s_state[r] = (rail_state_t){ .retain = held };
+        if (held) rail_switch(r, true);
+    }
+    s_rtc.held_mask = 0;
+    s_hook_count = 0;
+}
+
+void power_rail_acquire(power_rail_t rail)
+{
+    if (rail >= POWER_RAIL_COUNT) return;
+    taskENTER_CRITICAL(&s_lock);
+    bool first = (s_state[rail].refs++ == 0) && !s_state[rail].on;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (first) {
+        rail_switch(rail, true);
+        vTaskDelay(pdMS_TO_TICKS(s_rails[rail].settle_ms));
+    }
+}
+
+void power_rail_release(power_rail_t rail)
+{
+    if (rail >= POWER_RAIL_COUNT) return;
+    taskENTER_CRITICAL(&s_lock);
+    bool last = s_state[rail].refs > 0 && --s_state[rail].refs == 0 && !s_state[rail].retain;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (last) rail_switch(rail, false);
+}
+
+bool power_rail_is_on(power_rail_t rail)
+{
+    return rail < POWER_RAIL_COUNT && s_state[rail].on;
+}
+
+void power_rail_retain(power_rail_t rail, bool retain)
+{
+    if (rail >= POWER_RAIL_COUNT) return;
+    taskENTER_CRITICAL(&s_lock);
+    s_state[rail].retain = retain;
+    bool off = !retain && s_state[rail].refs == 0 && s_state[rail].on;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (off) rail_switch(rail, false);
+}
+
+void power_register_sleep_hook(power_sleep_hook_t hook)
+{
+    if (hook && s_hook_count < MAX_SLEEP_HOOKS) s_hooks[s_hook_count++] = hook;
+}
+
+void power_prepare_sleep(void)
+{
+    for (int i = 0; i < s_hook_count; i++) s_hooks[i]();
+
+    for (int r = 0; r < POWER_RAIL_COUNT; r++) {
+        const rail_def_t *def = &s_rails[r];
+        rail_state_t *st = &s_state[r];
+        bool keep = st->on && st->retain;
+
+        // Noch angeforderte, aber nicht gehaltene Schienen (Task über Budget) gehen aus
+        if (!keep && st->on) rail_switch(r, false);
+        if (keep) {
+            st->on_ms += (uint32_t)((esp_timer_get_time() - st->on_since_us) / 1000);
+            s_rtc.held_mask |= 1u << r;
+            s_rtc.held_sleeps[r]++;
+        }
+        gpio_hold_en(def->en_pin);
+
+        for (int i = 0; i < def->n_signals; i++) {
+            if (keep) {
+                signal_hold(&def->signals[i]);
+            } else {
+                signal_isolate(def->signals[i].pin);
+            }
+        }
+
+        s_rtc.on_ms_total[r] += st->on_ms;
+        ESP_LOGI(TAG_PWR, "%s: %lu ms an%s (seit Kaltstart %lu ms aktiv, %lu Deep Sleeps gehalten)",
+                 def->name, (unsigned long)st->on_ms, keep ? ", bleibt im Deep Sleep an" : "",
+                 (unsigned long)s_rtc.on_ms_total[r], (unsigned long)s_rtc.held_sleeps[r]);
+    }
+
+    // Digitale Pads (SD an GPIO38..48) halten ihren Zustand nur damit im Deep Sleep
+    gpio_deep_sleep_hold_en();
+}
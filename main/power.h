@@ -0,0 +1,51 @@
+// ==============================================
+// File: main/power.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Schaltbare Versorgungen (E-Paper an GPIO1, SD-Karte an GPIO2) mit
+ * Referenzzähler: die erste Anforderung schaltet ein und wartet die
+ * Einschwingzeit ab, die letzte Freigabe schaltet wieder ab, sofern die
+ * Schiene nicht über den Deep Sleep gehalten werden soll.
+ *
+ * Vor dem Deep Sleep laufen die registrierten Hooks (z.B. Panel schlafen
+ * legen), danach werden gehaltene Schienen samt Steuerpins per gpio_hold
+ * auf festen Pegeln gehalten und die Signale abgeschalteter Schienen
+ * isoliert (kein Pull, kein Treiber), damit nichts über die Pins in ein
+ * unversorgtes Gerät fließt.
+ */
+
+typedef enum {
+    POWER_RAIL_EPD = 0,
+    POWER_RAIL_SD,
+    POWER_RAIL_COUNT
+} power_rail_t;
+
+typedef void (*power_sleep_hook_t)(void);
+
+/* Einmal pro Wake vor allen Treibern: Pins übernehmen, im Deep Sleep
+ * gehaltene Schienen bleiben ohne Unterbrechung an. */
+void power_init(bool cold_boot);
+
+void power_rail_acquire(power_rail_t rail);
+void power_rail_release(power_rail_t rail);
+bool power_rail_is_on(power_rail_t rail);
+
+/* Schiene über den Deep Sleep eingeschaltet lassen (z.B. Panel-RAM behalten). */
+void power_rail_retain(power_rail_t rail, bool retain);
+
+/* Hook für power_prepare_sleep; läuft vor dem Halten/Isolieren der Pins. */
+void power_register_sleep_hook(power_sleep_hook_t hook);
+
+/* Direkt vor esp_deep_sleep_start: Hooks, Pins halten/isolieren, Einschaltzeiten loggen. */
+void power_prepare_sleep(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,25 +8,32 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_err.h" 
 #include "driver/gpio.h"
+#include "sdkconfig.h"
 
 #include "coaster_types.h"
 #include "print_task.h"
 #include "sntp_client.h"
+#include "wake_cycle.h"
+#include "wake_trace.h"
+#include "task_pool.h"
 
 #include "lvgl.h"
 
 #include "EPD_1in54_V2.h"
 #include "DEV_Config.h"
+#include "epd_refresh.h"
+#include "epd_lut.h"
+#include "power.h"
 
 typedef struct {
     QueueHandle_t q_coaster;
     QueueHandle_t q_park;
     QueueHandle_t q_time;
     const char *target_ride_name;
-    SemaphoreHandle_t done_sem;
     QueueHandle_t q_status_summary;
 } print_task_ctx_t;
 
@@ -41,6 +48,7 @@ static print_task_ctx_t s_ctx;
 /* 1) draw_mem: +8 Bytes für Palette */
 
 #define WORK_ROWS 10
+#define EPD_DIRTY_WINDOWS 4
 #define STRIDE_BYTES  ((HOR_RES + 7) >> 3)
 
 static uint8_t       draw_mem[STRIDE_BYTES * WORK_ROWS + 8];
@@ -92,105 +100,144 @@ static void my_flush(lv_display_t * disp, const lv_area_t * area, uint8_t * px_m
 
 
 
-static void print_task(void *arg)
+/* Zustand des Panels beim Deep Sleep */
+typedef enum {
+    PANEL_OFF = 0,          // unversorgt, RAM leer
+    PANEL_ASLEEP,           // versorgt, Controller im Deep Sleep, RAM erhalten
+    PANEL_REFRESHING,       // versorgt, Waveform läuft noch
+} panel_state_t;
+
+static RTC_DATA_ATTR panel_state_t s_panel_state;
+/* Controller in diesem Wake initialisiert und noch nicht schlafen gelegt */
+static bool s_panel_awake;
+/* Panel-RAM enthält (nach dem Waveform) den gespeicherten Frame */
+static bool s_panel_ram_ok;
+/* PANEL_REFRESHING: diese Fenster fehlen nach dem Waveform noch im alten RAM (0x26),
+ * der Rest der Bank stimmt schon. Nach einem Vollrefresh sind beide Bänke beschrieben. */
+static RTC_DATA_ATTR uint8_t s_sync_count;
+static RTC_DATA_ATTR EPD_1IN54_V2_Window s_sync_win[EPD_DIRTY_WINDOWS];
+/* Fenster der Ausgabe in diesem Wake, gelten erst mit dem verzögerten Waveform */
+static EPD_1IN54_V2_Window s_out_win[EPD_DIRTY_WINDOWS];
+static uint8_t s_out_count;
+
+/* Sleep-Hook: aufgeschobenen Refresh starten oder Panel schlafen legen */
+static void display_sleep_hook(void)
 {
-    print_task_ctx_t *ctx = (print_task_ctx_t *)arg;
-    if (ctx == NULL) {
-        vTaskDelete(NULL);
+    if (!s_panel_awake) {
+        /* In diesem Wake nicht angefasst: Zustand und RAM wie beim letzten Deep Sleep */
+        if (!power_rail_is_on(POWER_RAIL_EPD)) s_panel_state = PANEL_OFF;
         return;
     }
+    s_panel_awake = false;
 
-    time_t t_current;
-    time_t t_open_from;
-    time_t t_closed_from;
-
-    const char *ride_name = ctx->target_ride_name ? ctx->target_ride_name : "Unbekannt";
-
-    /* Ensure local time calculations use the expected TZ (same as SNTP task). */
-    setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
-    tzset();
-
-
-
-    ESP_ERROR_CHECK(gpio_set_direction(1, GPIO_MODE_OUTPUT));
-    ESP_ERROR_CHECK(gpio_set_level(1, 1));
-
-    vTaskDelay( 100 / portTICK_PERIOD_MS);
-
-
-    if (DEV_Module_Init() == 0) {
-        EPD_1IN54_V2_Init();
-        EPD_1IN54_V2_Clear();
-    } else {
-        printf("Fehler: Konnte Epaper nicht initialisieren.\n");
-        vTaskDelete(NULL);
+    if (!wake_cycle_done(WAKE_EVT_DISPLAY_DONE)) {
+        /* Print-Task hängt womöglich noch im SPI: Panel nicht anfassen, Versorgung fällt ab */
+        power_rail_retain(POWER_RAIL_EPD, false);
+        epd_refresh_set_panel_retained(false);
+        s_panel_state = PANEL_OFF;
         return;
     }
 
-    coaster_data_t* coaster_data = NULL;
-    if (xQueueReceive(ctx->q_coaster, &coaster_data, portMAX_DELAY) == pdTRUE) {
-        const char *coaster_name = coaster_data->name ? coaster_data->name : ride_name;
-        printf("Wartezeit %s: %d min\n", coaster_name, coaster_data->waitingtime);
-        printf("Status Coaster: %s\n", coaster_status_to_string(coaster_data->status));
-        free(coaster_data->name);
-    } else {
-        printf("Fehler: nichts aus Coaster Data Queue empfangen.\n");
-        vTaskDelete(NULL);
-        return;
-    }
-    park_data_t* park_data = NULL;
-    if (xQueueReceive(ctx->q_park, &park_data, portMAX_DELAY) == pdTRUE) {
-        printf("Park heute geöffnet: %s\n", park_data->opened_today ? "Ja" : "Nein");
-        printf("Park öffnet: %s\n", park_data->open_from);
-        printf("Park schließt: %s\n", park_data->closed_from);
+    if (EPD_1IN54_V2_ActivatePending()) {
+        printf("Display-Refresh gestartet, Waveform läuft im Deep Sleep weiter.\n");
+        s_panel_state = PANEL_REFRESHING;
+        s_sync_count = s_out_count;
+        memcpy(s_sync_win, s_out_win, sizeof(s_sync_win));
     } else {
-        printf("Fehler: nichts aus Park Data Queue empfangen.\n");
-        vTaskDelete(NULL);
-        return;
+        EPD_1IN54_V2_Sleep();
+        s_panel_state = PANEL_ASLEEP;
     }
-    time_data_t* time_data = NULL;
-    if (xQueueReceive(ctx->q_time, &time_data, portMAX_DELAY) == pdTRUE) {
 
-        struct tm* tm_local_ptr = time_data->time_local;
+    /* Versorgung nur halten, wenn das RAM etwas taugt (Teilrefresh im nächsten Wake) */
+    power_rail_retain(POWER_RAIL_EPD, s_panel_ram_ok || s_panel_state == PANEL_REFRESHING);
+    power_rail_release(POWER_RAIL_EPD);
+    if (!power_rail_is_on(POWER_RAIL_EPD)) s_panel_state = PANEL_OFF;
+    epd_refresh_set_panel_retained(s_panel_state != PANEL_OFF && s_panel_ram_ok);
+}
 
-        char buf[64];
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %Z", tm_local_ptr);
-        printf("Aktuelle Zeit: %s\n", buf);
+void display_resume(bool cold_boot)
+{
+    panel_state_t was = cold_boot ? PANEL_OFF : s_panel_state;
+    power_register_sleep_hook(display_sleep_hook);
 
-        t_current = mktime(tm_local_ptr);
-    } else {
-        printf("Fehler: nichts aus time Queue empfangen.\n");
-        vTaskDelete(NULL);
+    if (was == PANEL_OFF || !power_rail_is_on(POWER_RAIL_EPD)) {
+        /* Versorgung war weg (oder unbekannt): RAM-Inhalt des Panels ungültig */
+        s_panel_state = PANEL_OFF;
+        epd_refresh_set_panel_retained(false);
+        return;
+    }
+    if (was == PANEL_ASLEEP) {
         return;
     }
 
-    struct tm tm_park_open_from = {0};
-    strptime(park_data->open_from, "%Y-%m-%dT%H:%M:%S", &tm_park_open_from);
-
-    struct tm tm_park_closed_from = {0};
-    strptime(park_data->closed_from, "%Y-%m-%dT%H:%M:%S", &tm_park_closed_from);
-
-    t_open_from = mktime(&tm_park_open_from);
-    t_closed_from = mktime(&tm_park_closed_from);
-
-    double park_open_since_secs = difftime(t_current, t_open_from); // If positive, then park is open
-    printf("Park geöffnet seit %f Sekunden\n", park_open_since_secs);
+    /* Der im letzten Wake gestartete Waveform ist längst durch: nur die damals
+     * geänderten Fenster ins Vergleichsbild nachziehen und Panel schlafen legen */
+    power_rail_acquire(POWER_RAIL_EPD);
+    const uint8_t *last = NULL;
+    if (DEV_Module_Init() == 0) {
+        EPD_1IN54_V2_WaitIdle();
+        last = epd_refresh_last_frame();
+        if (last && s_sync_count) {
+            EPD_1IN54_V2_SyncOldRamWindows(last, s_sync_win, s_sync_count);
+        }
+        EPD_1IN54_V2_Sleep();
+    }
+    s_sync_count = 0;
+    power_rail_retain(POWER_RAIL_EPD, last != NULL);
+    power_rail_release(POWER_RAIL_EPD);
+    s_panel_state = last ? PANEL_ASLEEP : PANEL_OFF;
+    epd_refresh_set_panel_retained(last != NULL);
+}
 
-    double park_closed_since_secs = difftime(t_current, t_closed_from); // If positive, then park was open and now is closed
-    printf("Park geschlossen seit %f Sekunden\n", park_closed_since_secs);
+/* Panel einschalten und den Frame mit der geplanten Refresh-Art ausgeben */
+static bool panel_output(epd_refresh_t mode, time_t now)
+{
+    /* Einschwingzeit nur, wenn die Versorgung nicht ohnehin gehalten wurde;
+     * freigegeben wird im Sleep-Hook */
+    if (!s_panel_awake) {
+        power_rail_acquire(POWER_RAIL_EPD);
+        s_panel_awake = true;
+    }
 
-    if (park_open_since_secs < 0 && park_closed_since_secs < 0)
-        printf("Status Park: Noch nicht geöffnet\n");
-    else if (park_open_since_secs > 0 && park_closed_since_secs < 0)
-        printf("Status Park: Geöffnet\n");
-    else if (park_open_since_secs > 0 && park_closed_since_secs > 0)
-        printf("Status Park: Wieder geschlossen\n");
-    else
-        printf("Status Park: Wieder geschlossen, bevor er geöffnet war\n");
+    if (DEV_Module_Init() != 0) {
+        printf("Fehler: Konnte Epaper nicht initialisieren.\n");
+        return false;
+    }
 
+    /* Waveform nach Paneltemperatur, gemessen höchstens alle CONFIG_EPD_TEMP_CHECK_MIN Minuten */
+    epd_lut_select(now);
 
+#if CONFIG_EPD_REFRESH_IN_DEEP_SLEEP
+    /* Nur RAM laden; 0x20 schickt der Sleep-Hook direkt vor dem Deep Sleep */
+    EPD_1IN54_V2_DeferActivation(1);
+#endif
 
+    /* Ein Waveform pro Wake: kein Clear vorab, der Vollrefresh überschreibt alles */
+    s_out_count = 0;
+    if (mode == EPD_REFRESH_PARTIAL) {
+        /* Geänderte Fenster: übertragen (Panel-RAM stimmt noch) bzw. nach dem
+         * verzögerten Waveform ins alte RAM nachziehen */
+        s_out_count = (uint8_t)epd_refresh_dirty_windows(framebuffer_1bpp, s_out_win, EPD_DIRTY_WINDOWS);
+    }
+    if (mode == EPD_REFRESH_PARTIAL && epd_refresh_panel_ram_valid()) {
+        EPD_1IN54_V2_Init_Partial();
+        EPD_1IN54_V2_DisplayPartWindows(framebuffer_1bpp, s_out_win, s_out_count);
+    } else if (mode == EPD_REFRESH_PARTIAL) {
+        EPD_1IN54_V2_Init_Partial();
+        EPD_1IN54_V2_DisplayPartDiff(epd_refresh_last_frame(), framebuffer_1bpp);
+    } else {
+        /* Beide RAM-Bänke beschreiben, damit spätere Teilrefreshs Fenster nutzen können */
+        EPD_1IN54_V2_Init();
+        EPD_1IN54_V2_DisplayPartBaseImage(framebuffer_1bpp);
+    }
+    DEV_SPI_Report();
+    return true;
+}
 
+/* Rendert den Status per LVGL in framebuffer_1bpp und schreibt ihn aufs E-Paper,
+ * sofern sich der Frame gegenüber dem zuletzt angezeigten geändert hat */
+static bool display_update(const coaster_data_t *coaster_data, time_t t_current)
+{
     /* --- LVGL setup (v9, 1 bpp) --- */
     
 
@@ -280,12 +327,131 @@ static void print_task(void *arg)
 
     /* exakt EIN Frame rendern */
     lv_obj_invalidate(lv_screen_active());
+    wake_trace_begin(TRACE_LVGL_RENDER);
     lv_timer_handler();
+    wake_trace_end(TRACE_LVGL_RENDER);
 
     /* --- E-Paper-Ausgabe: nimm direkt den 1bpp-Framebuffer --- */
-    EPD_1IN54_V2_Display(framebuffer_1bpp);
+    epd_refresh_t mode = epd_refresh_plan(framebuffer_1bpp, t_current);
+    printf("Display-Refresh: %s\n", epd_refresh_to_string(mode));
+    if (mode == EPD_REFRESH_NONE) {
+        wake_cycle_set_outcome(WAKE_OUTCOME_UNCHANGED);
+        return true;
+    }
+
+    s_panel_ram_ok = false;
+    if (!panel_output(mode, t_current)) {
+        epd_refresh_invalidate();
+        return false;
+    }
+    epd_refresh_commit(framebuffer_1bpp, mode, t_current);
+    s_panel_ram_ok = true;
+    return true;
+}
+
+static void print_task(void *arg)
+{
+    print_task_ctx_t *ctx = (print_task_ctx_t *)arg;
+    if (ctx == NULL) {
+        task_pool_exit();
+        return;
+    }
+
+    time_t t_current;
+    time_t t_open_from = 0;
+    time_t t_closed_from = 0;
+
+    const char *ride_name = ctx->target_ride_name ? ctx->target_ride_name : "Unbekannt";
+
 
-    if (ctx->q_status_summary) {
+
+    /* Fetch meldet sich auch bei Fehlschlag -> Queues danach ohne Blockieren lesen */
+    if (!wake_cycle_wait(WAKE_EVT_API_DONE, WAKE_PHASE_FETCH)) {
+        printf("Fehler: API-Abruf nicht innerhalb der Deadline beendet.\n");
+    }
+
+    /* Nachrichten kommen als Kopie, nichts freizugeben */
+    coaster_data_t coaster_msg;
+    const coaster_data_t* coaster_data = NULL;
+    if (xQueueReceive(ctx->q_coaster, &coaster_msg, 0) == pdTRUE) {
+        coaster_data = &coaster_msg;
+        const char *coaster_name = coaster_data->name[0] ? coaster_data->name : ride_name;
+        printf("Wartezeit %s: %d min\n", coaster_name, coaster_data->waitingtime);
+        printf("Status Coaster: %s\n", coaster_status_to_string(coaster_data->status));
+    } else {
+        printf("Fehler: nichts aus Coaster Data Queue empfangen.\n");
+        wake_cycle_set_outcome(WAKE_OUTCOME_NO_DATA);
+        wake_cycle_signal(WAKE_EVT_DISPLAY_DONE);
+        task_pool_exit();
+        return;
+    }
+    park_data_t park_msg;
+    const park_data_t* park_data = NULL;
+    if (xQueueReceive(ctx->q_park, &park_msg, 0) == pdTRUE) {
+        park_data = &park_msg;
+        char buf[32];
+        struct tm tm_tmp;
+        printf("Park heute geöffnet: %s\n", park_data->opened_today ? "Ja" : "Nein");
+        strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", localtime_r(&park_data->open_from, &tm_tmp));
+        printf("Park öffnet: %s\n", buf);
+        strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", localtime_r(&park_data->closed_from, &tm_tmp));
+        printf("Park schließt: %s\n", buf);
+    } else {
+        printf("Fehler: nichts aus Park Data Queue empfangen.\n");
+    }
+    time_data_t time_data;
+    if (xQueueReceive(ctx->q_time, &time_data, wake_cycle_ticks_left(WAKE_PHASE_TIME)) == pdTRUE) {
+
+        struct tm tm_local;
+        localtime_r(&time_data.now, &tm_local);
+
+        char buf[64];
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %Z", &tm_local);
+        printf("Aktuelle Zeit: %s\n", buf);
+
+        t_current = time_data.now;
+    } else {
+        /* Systemzeit läuft im Deep Sleep weiter und ist als Ersatz gut genug */
+        printf("Fehler: nichts aus time Queue empfangen, verwende Systemzeit.\n");
+        t_current = time(NULL);
+    }
+    wake_cycle_mark(WAKE_PHASE_TIME);
+
+    if (park_data) {
+        t_open_from = park_data->open_from;
+        t_closed_from = park_data->closed_from;
+
+        double park_open_since_secs = difftime(t_current, t_open_from); // If positive, then park is open
+        printf("Park geöffnet seit %f Sekunden\n", park_open_since_secs);
+
+        double park_closed_since_secs = difftime(t_current, t_closed_from); // If positive, then park was open and now is closed
+        printf("Park geschlossen seit %f Sekunden\n", park_closed_since_secs);
+
+        if (park_open_since_secs < 0 && park_closed_since_secs < 0)
+            printf("Status Park: Noch nicht geöffnet\n");
+        else if (park_open_since_secs > 0 && park_closed_since_secs < 0)
+            printf("Status Park: Geöffnet\n");
+        else if (park_open_since_secs > 0 && park_closed_since_secs > 0)
+            printf("Status Park: Wieder geschlossen\n");
+        else
+            printf("Status Park: Wieder geschlossen, bevor er geöffnet war\n");
+    }
+
+
+
+
+    /* Nichts Neues vom Server und der letzte Frame steht auf dem Panel: weder rendern
+     * noch Panel anfassen. Ohne gespeicherten Frame (Ausgabe schlug fehl) neu zeichnen. */
+    if (coaster_data->unchanged && epd_refresh_last_frame() != NULL) {
+        printf("Daten unverändert, kein Display-Refresh.\n");
+        wake_cycle_set_outcome(WAKE_OUTCOME_UNCHANGED);
+    } else if (!display_update(coaster_data, t_current)) {
+        wake_cycle_set_outcome(WAKE_OUTCOME_NO_DATA);
+    }
+    wake_cycle_mark(WAKE_PHASE_DISPLAY);
+
+    /* Ohne Öffnungszeiten keine Zusammenfassung -> main plant das normale Intervall */
+    if (ctx->q_status_summary && park_data) {
         status_summary_t summary = {
             .coaster_status = coaster_data->status,
             .park_opened_today = park_data->opened_today,
@@ -296,26 +462,21 @@ static void print_task(void *arg)
         (void)xQueueOverwrite(ctx->q_status_summary, &summary);
     }
 
-    if (ctx->done_sem) {
-        xSemaphoreGive(ctx->done_sem);
-    }
-
-    vTaskDelete(NULL);
+    wake_cycle_signal(WAKE_EVT_DISPLAY_DONE);
+    task_pool_exit();
 }
 
 void start_print_task(QueueHandle_t q_coaster,
                       QueueHandle_t q_park,
                       QueueHandle_t q_time,
                       const char *target_ride_name,
-                      SemaphoreHandle_t done_sem,
                       QueueHandle_t q_status_summary)
 {
     s_ctx.q_coaster = q_coaster;
     s_ctx.q_park = q_park;
     s_ctx.q_time = q_time;
     s_ctx.target_ride_name = target_ride_name;
-    s_ctx.done_sem = done_sem;
     s_ctx.q_status_summary = q_status_summary;
 
-    xTaskCreate(print_task, "print_task", 4096, &s_ctx, 5, NULL);
+    task_pool_start(TASK_POOL_PRINT, print_task, &s_ctx);
 }
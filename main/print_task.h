@@ -15,11 +15,16 @@ typedef struct {
     time_t t_closed_from;
 } status_summary_t;
 
+/* Wake-Beginn (nach power_init): ein Panel, dessen Waveform im Deep Sleep
+ * lief, schlafen legen; ohne gehaltene Versorgung gilt das Panel-RAM als
+ * leer. Registriert den Sleep-Hook, der vor dem Deep Sleep einen
+ * aufgeschobenen Refresh startet oder das Panel schlafen legt. */
+void display_resume(bool cold_boot);
+
 void start_print_task(QueueHandle_t q_coaster,
                       QueueHandle_t q_park,
                       QueueHandle_t q_time,
                       const char *target_ride_name,
-                      SemaphoreHandle_t done_sem,
                       QueueHandle_t q_status_summary);
 
 #endif /* PRINT_TASK_H */
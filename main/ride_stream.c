@@ -0,0 +1,290 @@
+// ==============================================
+// File: main/ride_stream.c
+// ==============================================
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+
+#include "ride_stream.h"
+
+enum {
+    ST_VALUE = 0,   // Strukturzeichen / Whitespace
+    ST_STRING,
+    ST_ESCAPE,
+    ST_UNICODE,
+    ST_LITERAL,     // Zahl, true, false, null
+};
+
+static inline bool top_is_array(const ride_stream_t *rs)
+{
+    return rs->depth > 0 && (rs->array_mask & (1u << rs->depth)) != 0;
+}
+
+static void tok_putc(ride_stream_t *rs, char c)
+{
+    if (rs->tok_len + 1 < sizeof(rs->tok)) {
+        rs->tok[rs->tok_len++] = c;
+    } else {
+        rs->tok_truncated = true;
+    }
+}
+
+static void tok_put_utf8(ride_stream_t *rs, uint32_t cp)
+{
+    if (cp < 0x80) {
+        tok_putc(rs, (char)cp);
+    } else if (cp < 0x800) {
+        tok_putc(rs, (char)(0xC0 | (cp >> 6)));
+        tok_putc(rs, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        tok_putc(rs, (char)(0xE0 | (cp >> 12)));
+        tok_putc(rs, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        tok_putc(rs, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        tok_putc(rs, (char)(0xF0 | (cp >> 18)));
+        tok_putc(rs, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        tok_putc(rs, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        tok_putc(rs, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Liefert das Kandidaten-Objekt, dessen Felder gerade auf dieser Tiefe liegen (oder NULL)
+static ride_stream_item_t* current_item(ride_stream_t *rs)
+{
+    if (top_is_array(rs)) return NULL;
+    if (rs->elem_depth && rs->depth == rs->elem_depth) return &rs->cur[1];
+    if (rs->depth == 1) return &rs->cur[0];
+    return NULL;
+}
+
+static void finish_string(ride_stream_t *rs)
+{
+    rs->tok[rs->tok_len] = '\0';
+
+    if (rs->tok_is_key) {
+        if (rs->tok_truncated || rs->tok_len >= sizeof(rs->key)) {
+            rs->key[0] = '\0';
+        } else {
+            memcpy(rs->key, rs->tok, rs->tok_len + 1);
+        }
+        return;
+    }
+
+    ride_stream_item_t *item = current_item(rs);
+    if (!item) return;
+
+    // cJSON_GetObjectItem vergleicht Keys case-insensitiv und nimmt den ersten Treffer
+    if (!item->has_name && strcasecmp(rs->key, "name") == 0) {
+        memcpy(item->name, rs->tok, rs->tok_len + 1);
+        item->name_truncated = rs->tok_truncated;
+        item->has_name = true;
+    } else if (!item->has_status && strcasecmp(rs->key, "status") == 0) {
+        strlcpy(item->status, rs->tok, sizeof(item->status));
+        item->has_status = true;
+    }
+}
+
+static bool finish_literal(ride_stream_t *rs)
+{
+    rs->tok[rs->tok_len] = '\0';
+    const char *t = rs->tok;
+
+    if (!strcmp(t, "true") || !strcmp(t, "false") || !strcmp(t, "null")) return true;
+    if (rs->tok_truncated || !(t[0] == '-' || (t[0] >= '0' && t[0] <= '9'))) return false;
+
+    char *end = NULL;
+    double v = strtod(t, &end);
+    if (!end || *end != '\0') return false;
+
+    ride_stream_item_t *item = current_item(rs);
+    if (item && !item->has_waitingtime && strcasecmp(rs->key, "waitingtime") == 0) {
+        // Gleiche Sättigung wie cJSON valueint
+        if (v >= INT_MAX)      item->waitingtime = INT_MAX;
+        else if (v <= INT_MIN) item->waitingtime = INT_MIN;
+        else                   item->waitingtime = (int)v;
+        item->has_waitingtime = true;
+    }
+    return true;
+}
+
+static void emit_item(ride_stream_t *rs, const ride_stream_item_t *item)
+{
+    rs->items++;
+    if (rs->on_item && !rs->on_item(item, rs->ctx)) rs->result = RIDE_STREAM_DONE;
+}
+
+static void open_container(ride_stream_t *rs, bool is_array)
+{
+    if (rs->depth + 1 >= RIDE_STREAM_MAX_DEPTH) {
+        rs->result = RIDE_STREAM_ERROR;
+        return;
+    }
+    bool parent_is_array = top_is_array(rs);
+    uint8_t parent_depth = rs->depth;
+
+    if (is_array && parent_depth == 1 && !parent_is_array &&
+        (!strcasecmp(rs->key, "data") || !strcasecmp(rs->key, "items") || !strcasecmp(rs->key, "results"))) {
+        rs->in_list = true;
+        rs->root_has_list = true;
+    }
+
+    rs->depth++;
+    if (is_array) rs->array_mask |=  (1u << rs->depth);
+    else          rs->array_mask &= ~(1u << rs->depth);
+    rs->expect_key = !is_array;
+    rs->key[0] = '\0';
+
+    if (is_array) return;
+
+    if (rs->depth == 1) {
+        memset(&rs->cur[0], 0, sizeof(rs->cur[0]));
+    } else if (parent_is_array && rs->elem_depth == 0 &&
+               (parent_depth == 1 || (parent_depth == 2 && rs->in_list))) {
+        // Element des Root-Arrays oder von data/items/results im Root-Objekt
+        rs->elem_depth = rs->depth;
+        memset(&rs->cur[1], 0, sizeof(rs->cur[1]));
+    }
+}
+
+static void close_container(ride_stream_t *rs, bool is_array)
+{
+    if (rs->depth == 0 || top_is_array(rs) != is_array) {
+        rs->result = RIDE_STREAM_ERROR;
+        return;
+    }
+
+    if (!is_array) {
+        if (rs->elem_depth && rs->depth == rs->elem_depth) {
+            rs->elem_depth = 0;
+            emit_item(rs, &rs->cur[1]);
+        } else if (rs->depth == 1 && !rs->root_has_list && rs->cur[0].has_name) {
+            emit_item(rs, &rs->cur[0]);
+        }
+    } else if (rs->depth == 2) {
+        rs->in_list = false;
+    }
+
+    rs->depth--;
+    rs->expect_key = false;
+}
+
+void ride_stream_init(ride_stream_t *rs, ride_stream_item_cb_t on_item, void *ctx)
+{
+    if (!rs) return;
+    memset(rs, 0, sizeof(*rs));
+    rs->on_item = on_item;
+    rs->ctx = ctx;
+    rs->state = ST_VALUE;
+    rs->result = RIDE_STREAM_CONTINUE;
+}
+
+ride_stream_result_t ride_stream_feed(ride_stream_t *rs, const char *data, size_t len)
+{
+    if (!rs) return RIDE_STREAM_ERROR;
+    if (rs->result != RIDE_STREAM_CONTINUE || !data) return rs->result;
+
+    for (size_t i = 0; i < len && rs->result == RIDE_STREAM_CONTINUE; i++) {
+        char c = data[i];
+        rs->consumed++;
+
+        switch (rs->state) {
+        case ST_STRING:
+            if (c == '"') {
+                finish_string(rs);
+                rs->state = ST_VALUE;
+            } else if (c == '\\') {
+                rs->state = ST_ESCAPE;
+            } else {
+                tok_putc(rs, c);
+            }
+            break;
+
+        case ST_ESCAPE:
+            rs->state = ST_STRING;
+            switch (c) {
+                case 'b': tok_putc(rs, '\b'); break;
+                case 'f': tok_putc(rs, '\f'); break;
+                case 'n': tok_putc(rs, '\n'); break;
+                case 'r': tok_putc(rs, '\r'); break;
+                case 't': tok_putc(rs, '\t'); break;
+                case 'u': rs->state = ST_UNICODE; rs->ucode = 0; rs->udigits = 0; break;
+                default:  tok_putc(rs, c); break;  // \" \\ \/
+            }
+            break;
+
+        case ST_UNICODE: {
+            int nib;
+            if      (c >= '0' && c <= '9') nib = c - '0';
+            else if (c >= 'a' && c <= 'f') nib = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') nib = c - 'A' + 10;
+            else { rs->result = RIDE_STREAM_ERROR; break; }
+            rs->ucode = (rs->ucode << 4) | (uint32_t)nib;
+            if (++rs->udigits < 4) break;
+
+            rs->state = ST_STRING;
+            if (rs->ucode >= 0xD800 && rs->ucode <= 0xDBFF) {
+                rs->surrogate = (uint16_t)rs->ucode;
+            } else if (rs->ucode >= 0xDC00 && rs->ucode <= 0xDFFF && rs->surrogate) {
+                tok_put_utf8(rs, 0x10000 + (((uint32_t)rs->surrogate - 0xD800) << 10) + (rs->ucode - 0xDC00));
+                rs->surrogate = 0;
+            } else {
+                tok_put_utf8(rs, rs->ucode);
+                rs->surrogate = 0;
+            }
+        } break;
+
+        case ST_LITERAL:
+            if (c != ',' && c != '}' && c != ']' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                tok_putc(rs, c);
+                break;
+            }
+            if (!finish_literal(rs)) { rs->result = RIDE_STREAM_ERROR; break; }
+            rs->state = ST_VALUE;
+            /* fall through - Trennzeichen als Struktur verarbeiten */
+
+        case ST_VALUE:
+            switch (c) {
+                case ' ': case '\t': case '\r': case '\n':
+                    break;
+                case '{': open_container(rs, false); break;
+                case '[': open_container(rs, true);  break;
+                case '}': close_container(rs, false); break;
+                case ']': close_container(rs, true);  break;
+                case ',':
+                    if (rs->depth == 0) rs->result = RIDE_STREAM_ERROR;
+                    else if (!top_is_array(rs)) rs->expect_key = true;
+                    break;
+                case ':':
+                    rs->expect_key = false;
+                    break;
+                case '"':
+                    rs->state = ST_STRING;
+                    rs->tok_len = 0;
+                    rs->tok_truncated = false;
+                    rs->tok_is_key = !top_is_array(rs) && rs->expect_key && rs->depth > 0;
+                    rs->surrogate = 0;
+                    break;
+                default:
+                    rs->state = ST_LITERAL;
+                    rs->tok_len = 0;
+                    rs->tok_truncated = false;
+                    tok_putc(rs, c);
+                    break;
+            }
+            break;
+        }
+    }
+    return rs->result;
+}
+
+bool ride_stream_finish(ride_stream_t *rs)
+{
+    if (!rs) return false;
+    if (rs->result == RIDE_STREAM_CONTINUE && rs->state == ST_LITERAL && rs->depth == 0) {
+        (void)finish_literal(rs);
+        rs->state = ST_VALUE;
+    }
+    if (rs->result == RIDE_STREAM_DONE) return true;
+    return rs->result == RIDE_STREAM_CONTINUE && rs->depth == 0 && rs->state == ST_VALUE;
+}
@@ -0,0 +1,85 @@
+// ==============================================
+// File: main/ride_stream.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Inkrementeller (SAX-artiger) Parser für die waitingtimes-Antwort.
+ * Wird chunkweise gefüttert und meldet jedes Attraktions-Objekt einzeln an
+ * den Callback, ohne die Antwort als Baum aufzubauen. Attraktionen sind
+ * Elemente eines Root-Arrays, Elemente von "data"/"items"/"results" eines
+ * Root-Objekts oder (ohne solche Liste) das Root-Objekt selbst.
+ */
+
+#define RIDE_STREAM_NAME_MAX    64
+#define RIDE_STREAM_STATUS_MAX  24
+#define RIDE_STREAM_KEY_MAX     16
+#define RIDE_STREAM_MAX_DEPTH   32
+
+typedef enum {
+    RIDE_STREAM_CONTINUE = 0,   // weiter füttern
+    RIDE_STREAM_DONE,           // Callback hat beendet, Transfer kann abgebrochen werden
+    RIDE_STREAM_ERROR,          // Syntaxfehler oder zu tiefe Verschachtelung
+} ride_stream_result_t;
+
+typedef struct {
+    char name[RIDE_STREAM_NAME_MAX];
+    char status[RIDE_STREAM_STATUS_MAX];
+    int  waitingtime;
+    bool has_name;
+    bool has_status;
+    bool has_waitingtime;
+    bool name_truncated;
+} ride_stream_item_t;
+
+// Wird pro vollständigem Attraktions-Objekt aufgerufen; false beendet das Parsen (DONE)
+typedef bool (*ride_stream_item_cb_t)(const ride_stream_item_t *item, void *ctx);
+
+typedef struct {
+    ride_stream_item_cb_t on_item;
+    void    *ctx;
+
+    /* Tokenizer */
+    uint8_t  state;
+    uint8_t  depth;
+    uint32_t array_mask;        // Bit d gesetzt: Container auf Tiefe d ist ein Array
+    bool     expect_key;
+    char     key[RIDE_STREAM_KEY_MAX];
+    char     tok[RIDE_STREAM_NAME_MAX];
+    size_t   tok_len;
+    bool     tok_truncated;
+    bool     tok_is_key;
+    uint32_t ucode;
+    uint8_t  udigits;
+    uint16_t surrogate;
+
+    /* Kandidaten: [0] = Root-Objekt, [1] = aktuelles Array-Element */
+    ride_stream_item_t cur[2];
+    uint8_t  elem_depth;        // Tiefe des aktuellen Array-Elements, 0 = keines
+    bool     in_list;           // innerhalb von data/items/results des Root-Objekts
+    bool     root_has_list;
+
+    uint16_t items;             // gemeldete Objekte
+    ride_stream_result_t result;
+    size_t   consumed;
+} ride_stream_t;
+
+void ride_stream_init(ride_stream_t *rs, ride_stream_item_cb_t on_item, void *ctx);
+
+/* Füttert den nächsten Chunk. Nach DONE/ERROR werden weitere Daten ignoriert. */
+ride_stream_result_t ride_stream_feed(ride_stream_t *rs, const char *data, size_t len);
+
+/* Abschluss nach dem letzten Chunk; liefert true, wenn die Antwort vollständig
+ * gelesen oder vom Callback beendet wurde (kein Syntaxfehler, nicht abgeschnitten). */
+bool ride_stream_finish(ride_stream_t *rs);
+
+#ifdef __cplusplus
+}
+#endif
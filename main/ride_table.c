@@ -0,0 +1,95 @@
+// ==============================================
+// File: main/ride_table.c
+// ==============================================
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "ride_table.h"
+
+uint32_t ride_table_hash(const char *name)
+{
+    uint32_t h = 2166136261u;
+    if (!name) return h;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= (uint8_t)tolower(*p);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint32_t ride_table_check(const char *name)
+{
+    uint32_t h = 5381u;
+    if (!name) return h;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h = (h * 33u) ^ (uint8_t)tolower(*p);
+    }
+    return h;
+}
+
+void ride_table_clear(ride_table_t *t)
+{
+    if (t) memset(t, 0, sizeof(*t));
+}
+
+// Index-Position des Namens bzw. der ersten freien Stelle (lineares Sondieren);
+// ein Slot passt nur, wenn beide Hashes übereinstimmen
+static size_t probe(const ride_table_t *t, uint32_t name_hash, uint32_t name_check)
+{
+    size_t i = name_hash & (RIDE_TABLE_INDEX - 1);
+    while (t->index[i]) {
+        int slot = t->index[i] - 1;
+        if (t->name_hash[slot] == name_hash && t->name_check[slot] == name_check) break;
+        i = (i + 1) & (RIDE_TABLE_INDEX - 1);
+    }
+    return i;
+}
+
+int ride_table_add(ride_table_t *t, const char *name, int waitingtime, coaster_status_t status)
+{
+    if (!t || !name) return -1;
+    uint32_t name_hash  = ride_table_hash(name);
+    uint32_t name_check = ride_table_check(name);
+    size_t i = probe(t, name_hash, name_check);
+    if (t->index[i]) return t->index[i] - 1;
+
+    if (t->count >= RIDE_TABLE_SLOTS) {
+        t->full = true;
+        return -1;
+    }
+
+    int slot = t->count++;
+    if (waitingtime > INT16_MAX)      waitingtime = INT16_MAX;
+    else if (waitingtime < INT16_MIN) waitingtime = INT16_MIN;
+
+    t->name_hash[slot]  = name_hash;
+    t->name_check[slot] = name_check;
+    t->wait[slot]       = (int16_t)waitingtime;
+    t->status[slot]     = (uint8_t)(int8_t)status;
+    t->index[i]         = (uint8_t)(slot + 1);
+    return slot;
+}
+
+int ride_table_find(const ride_table_t *t, const char *name)
+{
+    if (!t || !name) return -1;
+    size_t i = probe(t, ride_table_hash(name), ride_table_check(name));
+    return t->index[i] ? t->index[i] - 1 : -1;
+}
+
+bool ride_collect_item(const ride_stream_item_t *item, void *ctx)
+{
+    ride_collect_t *rc = (ride_collect_t *)ctx;
+    if (!item->has_name || item->name_truncated) return true;
+
+    ride_table_add(rc->rides, item->name,
+                   item->has_waitingtime ? item->waitingtime : 0,
+                   item->has_status ? coaster_status_from_string(item->status) : COASTER_UNKNOWN);
+
+    if (!rc->found && rc->target && strcasecmp(item->name, rc->target) == 0) {
+        rc->found = true;
+        strlcpy(rc->name, item->name, sizeof(rc->name));
+    }
+    return !rc->found;  // konfigurierte Attraktion gefunden -> Rest nicht mehr übertragen
+}
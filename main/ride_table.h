@@ -0,0 +1,72 @@
+// ==============================================
+// File: main/ride_table.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "coaster_types.h"
+#include "ride_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Kompakte Tabelle aller Attraktionen einer waitingtimes-Antwort
+ * (Struct-of-Arrays, ~0,9 KB, passt in RTC-Memory). Namen werden nur als
+ * FNV-1a-Hash (case-insensitiv wie strcasecmp) gespeichert; ein offener
+ * Hash-Index liefert den Slot in O(1). Ein zweiter, unabhängiger Hash pro
+ * Slot bestätigt jeden Treffer, damit zwei Namen mit gleichem FNV-Wert
+ * getrennte Einträge bleiben.
+ */
+
+#define RIDE_TABLE_SLOTS    64
+#define RIDE_TABLE_INDEX    128     // Zweierpotenz, mind. doppelt so groß wie SLOTS
+
+typedef struct {
+    uint8_t  count;
+    bool     full;                          // weitere Attraktionen verworfen
+    uint32_t name_hash[RIDE_TABLE_SLOTS];
+    uint32_t name_check[RIDE_TABLE_SLOTS];  // ride_table_check(name)
+    int16_t  wait[RIDE_TABLE_SLOTS];        // Minuten
+    uint8_t  status[RIDE_TABLE_SLOTS];      // coaster_status_t, 0xFF = unbekannt
+    uint8_t  index[RIDE_TABLE_INDEX];       // Slot + 1, 0 = frei
+} ride_table_t;
+
+uint32_t ride_table_hash(const char *name);
+
+/* Zweiter Hash (djb2-xor, ebenfalls case-insensitiv) zur Bestätigung. */
+uint32_t ride_table_check(const char *name);
+
+void ride_table_clear(ride_table_t *t);
+
+/* Legt eine Attraktion an; bei schon vorhandenem Namen gilt der erste Eintrag.
+ * Liefert den Slot oder -1, wenn die Tabelle voll ist. */
+int ride_table_add(ride_table_t *t, const char *name, int waitingtime, coaster_status_t status);
+
+/* Slot zur Attraktion (Vergleich wie strcasecmp) oder -1. */
+int ride_table_find(const ride_table_t *t, const char *name);
+
+/* Sammelt die Objekte eines ride_stream in eine Tabelle, bis die konfigurierte
+ * Attraktion gesehen wurde; danach beendet der Callback den Stream (DONE),
+ * der Rest der Antwort muss nicht mehr übertragen werden. */
+typedef struct {
+    ride_table_t *rides;
+    const char   *target;                       // konfigurierter Name
+    bool          found;
+    char          name[RIDE_STREAM_NAME_MAX];   // Schreibweise laut API
+} ride_collect_t;
+
+/* ride_stream_item_cb_t; ctx ist ein ride_collect_t. */
+bool ride_collect_item(const ride_stream_item_t *item, void *ctx);
+
+static inline coaster_status_t ride_table_status(const ride_table_t *t, int slot)
+{
+    return (coaster_status_t)(int8_t)t->status[slot];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,9 +20,19 @@
 
 
 #include "sntp_client.h"
+#include "wake_cycle.h"
+#include "wake_trace.h"
+#include "wake_arena.h"
+#include "task_pool.h"
 
 static const char* TAG_RTC = "rtc_task";
 
+typedef struct {
+    QueueHandle_t q_time;
+} rtc_task_ctx_t;
+
+static rtc_task_ctx_t s_ctx;
+
 
 
 uint8_t bcd2bin(uint8_t in)
@@ -136,12 +146,12 @@ static esp_err_t rtc_write_reg(i2c_master_dev_handle_t rtc_dev_handle, uint8_t r
 static esp_err_t rtc_write_regs(i2c_master_dev_handle_t rtc_dev_handle, uint8_t start_reg, const uint8_t *data, size_t len)
 {
     if (!rtc_dev_handle || !data || len == 0) return ESP_ERR_INVALID_ARG;
-    uint8_t *buf = (uint8_t *)calloc(1, len + 1);
+    uint8_t *buf = (uint8_t *)wake_arena_calloc(WAKE_ARENA_INTERNAL, 1, len + 1);
     if (!buf) return ESP_ERR_NO_MEM;
     buf[0] = start_reg;
     memcpy(&buf[1], data, len);
     esp_err_t err = i2c_master_transmit(rtc_dev_handle, buf, len + 1, 10 /*ms*/);
-    free(buf);
+    wake_arena_free(buf);
     return err;
 }
 
@@ -220,11 +230,8 @@ esp_err_t rtc_setup_wakeup_source_gpio(gpio_num_t gpio_num)
     return esp_sleep_enable_ext0_wakeup(gpio_num, 0 /*active LOW*/);
 }
 
-esp_err_t rtc_read_current_time(time_data_t **out_time)
+static esp_err_t rtc_read_time(time_data_t *out_time)
 {
-    if (!out_time) return ESP_ERR_INVALID_ARG;
-    *out_time = NULL;
-
     i2c_master_bus_handle_t bus_handle = NULL;
     i2c_master_dev_handle_t rtc_dev_handle = NULL;
     esp_err_t err = rtc_create_handles(&bus_handle, &rtc_dev_handle);
@@ -241,37 +248,24 @@ esp_err_t rtc_read_current_time(time_data_t **out_time)
         return err;
     }
 
-    struct tm *tm_local = (struct tm *)calloc(1, sizeof(struct tm));
-    if (!tm_local) {
-        rtc_destroy_handles(bus_handle, rtc_dev_handle);
-        return ESP_ERR_NO_MEM;
-    }
-    buffer_to_struct_tm(read_buf, tm_local);
-
-    time_t now = mktime(tm_local);
-    struct tm *tm_utc = (struct tm *)calloc(1, sizeof(struct tm));
-    if (!tm_utc) {
-        free(tm_local);
-        rtc_destroy_handles(bus_handle, rtc_dev_handle);
-        return ESP_ERR_NO_MEM;
-    }
-    gmtime_r(&now, tm_utc);
-
-    time_data_t *time_data = (time_data_t *)calloc(1, sizeof(time_data_t));
-    if (!time_data) {
-        free(tm_local);
-        free(tm_utc);
-        rtc_destroy_handles(bus_handle, rtc_dev_handle);
-        return ESP_ERR_NO_MEM;
-    }
-    time_data->time_local = tm_local;
-    time_data->time_utc = tm_utc;
-    *out_time = time_data;
+    struct tm tm_local = {0};
+    buffer_to_struct_tm(read_buf, &tm_local);
+    tm_local.tm_isdst = -1;     // RTC läuft in Lokalzeit, Sommerzeit bestimmt mktime
+    out_time->now = mktime(&tm_local);
 
     rtc_destroy_handles(bus_handle, rtc_dev_handle);
     return ESP_OK;
 }
 
+esp_err_t rtc_read_current_time(time_data_t *out_time)
+{
+    if (!out_time) return ESP_ERR_INVALID_ARG;
+    wake_trace_begin(TRACE_RTC_READ);
+    esp_err_t err = rtc_read_time(out_time);
+    wake_trace_end(TRACE_RTC_READ);
+    return err;
+}
+
 esp_err_t rtc_schedule_next_alarm(uint8_t add_hours, uint8_t add_minutes)
 {
     i2c_master_bus_handle_t bus_handle = NULL;
@@ -339,12 +333,9 @@ esp_err_t rtc_schedule_alarm_time_of_day(uint8_t hour, uint8_t minute)
 // Task: rtc_task ()
 static void rtc_task(void* arg)
 {
-    void** pack = (void**)arg;
-    QueueHandle_t in_q_time = (QueueHandle_t)pack[0];
-    free(pack);
-    
-    vTaskDelay( 3000 / portTICK_PERIOD_MS);
-    
+    const rtc_task_ctx_t* ctx = (const rtc_task_ctx_t*)arg;
+    QueueHandle_t in_q_time = ctx->q_time;
+
     // Use shared helper to create I2C handles
     i2c_master_bus_handle_t bus_handle = NULL;
     i2c_master_dev_handle_t rtc_dev_handle = NULL;
@@ -356,36 +347,38 @@ static void rtc_task(void* arg)
     uint8_t startaddr = PCF85263A_REG_100TH_SECONDS;
 
 
-    struct tm *tm_struct = (struct tm *) calloc(1, sizeof(struct tm));
+    struct tm tm_struct = {0};
 
 
     ESP_ERROR_CHECK(i2c_master_transmit_receive(rtc_dev_handle, &startaddr, 1, read_buf, sizeof(read_buf), 10 /*ms*/));
     //ESP_LOGI(TAG_RTC, "Sekunde aktuell: %d%d s, Hundertstel Sekunden aktuell: %d%d ms", (read_buf[1]>>4)&0x07, read_buf[1]&0x0F, (read_buf[0]>>4)&0x0F, (read_buf[0]&0x0F));
-    buffer_to_struct_tm(read_buf, tm_struct);
+    buffer_to_struct_tm(read_buf, &tm_struct);
     char printfbuf[80];
-    strftime(printfbuf, 80, "Heutiges Datum: %d.%m.%Y, Uhrzeit: %H:%M:%S", tm_struct);
+    strftime(printfbuf, 80, "Heutiges Datum: %d.%m.%Y, Uhrzeit: %H:%M:%S", &tm_struct);
     ESP_LOGI(TAG_RTC, "%s", printfbuf);
 
 
-    time_data_t* time_data = NULL;
-    if (xQueueReceive(in_q_time, &time_data, portMAX_DELAY) == pdTRUE) {
-        struct tm* tm_local_ptr = time_data->time_local;
+    time_data_t time_data;
+    if (xQueueReceive(in_q_time, &time_data, wake_cycle_ticks_left(WAKE_PHASE_TIME)) == pdTRUE) {
+        struct tm tm_local;
+        localtime_r(&time_data.now, &tm_local);
         uint8_t write_buf[9];
         write_buf[0] = PCF85263A_REG_100TH_SECONDS;
-        struct_tm_to_buffer(tm_local_ptr, &write_buf[1]);
+        struct_tm_to_buffer(&tm_local, &write_buf[1]);
+        wake_trace_begin(TRACE_RTC_SET);
         ESP_ERROR_CHECK(i2c_master_transmit(rtc_dev_handle, write_buf, sizeof(write_buf), 10 /*ms*/));
+        wake_trace_end(TRACE_RTC_SET);
         ESP_LOGI(TAG_RTC, "rtc zeit via sntp gesetzt");
     } else {
         printf("Fehler: nichts aus time Queue empfangen.\n");
-        vTaskDelete(NULL);
-        return;
     }
     // Anything below here (e.g., looping) not needed currently.
 
 
 
     rtc_destroy_handles(bus_handle, rtc_dev_handle);
-    vTaskDelete(NULL);
+    wake_cycle_signal(WAKE_EVT_RTC_DONE);
+    task_pool_exit();
 }
 
 // -----------------------------------------------------------------------------
@@ -393,7 +386,6 @@ static void rtc_task(void* arg)
 // -----------------------------------------------------------------------------
 void start_rtc_task(QueueHandle_t in_queue_time)
 {
-    void** pack = calloc(1, sizeof(void*));
-    pack[0] = (void*)in_queue_time;
-    xTaskCreate(rtc_task, "rtc_task", 8192, pack, 5, NULL);
+    s_ctx.q_time = in_queue_time;
+    task_pool_start(TASK_POOL_RTC, rtc_task, &s_ctx);
 }
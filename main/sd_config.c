@@ -2,6 +2,7 @@
 // File: main/sd_config.c
 // ==============================================
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 #include "freertos/FreeRTOS.h"
@@ -9,45 +10,62 @@
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
 #include "esp_vfs_fat.h"
 #include "driver/sdmmc_host.h"
 #include "sdmmc_cmd.h"
 #include "sd_config.h"
+#include "ride_table.h"
+#include "wake_trace.h"
+#include "power.h"
 #include <strings.h>
+#include <ctype.h>
 
 static const char *TAG_SD = "sd_config";
 
-/* GPIO mapping */
-#define SD_PWR_EN_GPIO  GPIO_NUM_2
-#define SD_CD_GPIO      GPIO_NUM_47  /* Card detect (SW) active LOW */
-#define SD_PIN_CLK      GPIO_NUM_39
-#define SD_PIN_CMD      GPIO_NUM_40
-#define SD_PIN_D0       GPIO_NUM_38
-#define SD_PIN_D1       GPIO_NUM_48
-#define SD_PIN_D2       GPIO_NUM_42
-#define SD_PIN_D3       GPIO_NUM_41
-
 /* Mount point */
 #define SD_MOUNT_POINT "/sdcard"
 #define SD_CONFIG_FILE SD_MOUNT_POINT"/config.txt"
+#define SD_TRACE_FILE  SD_MOUNT_POINT"/trace.csv"
+
+/* Card detect: settle time after enabling the pull-up, attempts to get two equal reads */
+#define SD_CD_SETTLE_US     200
+#define SD_CD_READ_TRIES    5
+
+/* Defaults for keys missing in config.txt */
+#define SD_DEFAULT_PARK_ID          "30816cc0-aedb-4bfc-a180-b269a3a2f31d"
+#define SD_DEFAULT_RIDE             "Voltron Nevera"
+#define SD_DEFAULT_TZ               "CET-1CEST,M3.5.0/2,M10.5.0/3"
+#define SD_DEFAULT_WAKE_HOURS       0
+#define SD_DEFAULT_WAKE_MINUTES     1
+#define SD_DEFAULT_REFRESH_HOUR     4
+#define SD_DEFAULT_REFRESH_MINUTE   0
+
+/* Cached config, survives deep sleep */
+typedef struct {
+    uint16_t    version;
+    uint16_t    size;
+    uint32_t    crc;            // over card_present, has_config, cfg
+    uint8_t     card_present;
+    uint8_t     has_config;
+    sd_config_t cfg;
+} sd_config_blob_t;
 
+static RTC_DATA_ATTR sd_config_blob_t s_blob;
+static bool s_loaded = false;
+static sd_config_t s_defaults;
+
+/* Rail switching, settle time and sleep isolation live in power.c */
 static void sd_power_on(void)
 {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = 1ULL << SD_PWR_EN_GPIO,
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&io_conf);
-    gpio_set_level(SD_PWR_EN_GPIO, 1);
-    vTaskDelay(pdMS_TO_TICKS(10)); // let power rail settle
+    power_rail_acquire(POWER_RAIL_SD);
 }
 
 static void sd_power_off(void)
 {
-    gpio_set_level(SD_PWR_EN_GPIO, 0);
+    power_rail_release(POWER_RAIL_SD);
 }
 
 static bool sd_card_present(void)
@@ -60,12 +78,67 @@ static bool sd_card_present(void)
         .intr_type = GPIO_INTR_DISABLE,
     };
     gpio_config(&io_conf);
-    int level = gpio_get_level(SD_CD_GPIO);
+
+    // The pin floats through deep sleep (power.c), so the pull-up has to charge
+    // the line first. Two equal reads in a row count; a bounce retries.
+    int level = -1;
+    for (int i = 0; i < SD_CD_READ_TRIES && level < 0; i++) {
+        esp_rom_delay_us(SD_CD_SETTLE_US);
+        int first = gpio_get_level(SD_CD_GPIO);
+        esp_rom_delay_us(SD_CD_SETTLE_US);
+        if (gpio_get_level(SD_CD_GPIO) == first) level = first;
+    }
+    if (level < 0) {
+        level = gpio_get_level(SD_CD_GPIO);
+        ESP_LOGW(TAG_SD, "Card detect unstable, using last read (%d)", level);
+    }
     // Active LOW: 0 means card inserted.
     return level == 0;
 }
 
-static bool parse_line(char *line, char **out_ssid, char **out_pass)
+static void config_defaults(sd_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    strlcpy(cfg->park_id, SD_DEFAULT_PARK_ID, sizeof(cfg->park_id));
+    strlcpy(cfg->ride_name, SD_DEFAULT_RIDE, sizeof(cfg->ride_name));
+    strlcpy(cfg->tz, SD_DEFAULT_TZ, sizeof(cfg->tz));
+    cfg->wake_interval_hours   = SD_DEFAULT_WAKE_HOURS;
+    cfg->wake_interval_minutes = SD_DEFAULT_WAKE_MINUTES;
+    cfg->refresh_hour          = SD_DEFAULT_REFRESH_HOUR;
+    cfg->refresh_minute        = SD_DEFAULT_REFRESH_MINUTE;
+}
+
+/* Derived values and sanity checks after all keys have been applied */
+static void config_finalize(sd_config_t *cfg)
+{
+    if (cfg->wake_interval_hours == 0 && cfg->wake_interval_minutes == 0) {
+        ESP_LOGW(TAG_SD, "Wake interval 0, using %d min", SD_DEFAULT_WAKE_MINUTES);
+        cfg->wake_interval_minutes = SD_DEFAULT_WAKE_MINUTES;
+    }
+    cfg->ride_hash = ride_table_hash(cfg->ride_name);
+}
+
+static bool parse_uint(const char *val, unsigned max, uint8_t *out)
+{
+    char *end = NULL;
+    long v = strtol(val, &end, 10);
+    while (end && (*end == ' ' || *end == '\t')) end++;
+    if (!end || end == val || *end != '\0' || v < 0 || v > (long)max) return false;
+    *out = (uint8_t)v;
+    return true;
+}
+
+/* POSIX TZ rule: std name (alpha or <...>) followed by an offset */
+static bool tz_valid(const char *tz)
+{
+    if (!tz || !tz[0]) return false;
+    if (tz[0] == '<') return strchr(tz, '>') != NULL;
+    int n = 0;
+    while (isalpha((unsigned char)tz[n])) n++;
+    return n >= 3 && (tz[n] == '+' || tz[n] == '-' || isdigit((unsigned char)tz[n]));
+}
+
+static bool parse_line(char *line, sd_config_t *cfg)
 {
     if (!line) return false;
     size_t len = strlen(line);
@@ -86,34 +159,65 @@ static bool parse_line(char *line, char **out_ssid, char **out_pass)
         if (key[i] == ' ' || key[i] == '\t') key[i] = '\0'; else break;
     }
 
+    bool ok = true;
     if (strcasecmp(key, "WIFI_SSID") == 0) {
-        free(*out_ssid);
-        *out_ssid = strdup(val);
-        return true;
+        strlcpy(cfg->ssid, val, sizeof(cfg->ssid));
     } else if (strcasecmp(key, "WIFI_PASS") == 0 || strcasecmp(key, "WIFI_PASSWORD") == 0) {
-        free(*out_pass);
-        *out_pass = strdup(val);
-        return true;
+        strlcpy(cfg->password, val, sizeof(cfg->password));
+    } else if (strcasecmp(key, "PARK_ID") == 0) {
+        ok = val[0] && strlcpy(cfg->park_id, val, sizeof(cfg->park_id)) < sizeof(cfg->park_id);
+    } else if (strcasecmp(key, "RIDE") == 0 || strcasecmp(key, "TARGET_RIDE_NAME") == 0) {
+        ok = val[0] && strlcpy(cfg->ride_name, val, sizeof(cfg->ride_name)) < sizeof(cfg->ride_name);
+    } else if (strcasecmp(key, "TZ") == 0) {
+        ok = tz_valid(val) && strlcpy(cfg->tz, val, sizeof(cfg->tz)) < sizeof(cfg->tz);
+    } else if (strcasecmp(key, "WAKE_INTERVAL_HOURS") == 0) {
+        ok = parse_uint(val, 23, &cfg->wake_interval_hours);
+    } else if (strcasecmp(key, "WAKE_INTERVAL_MINUTES") == 0) {
+        ok = parse_uint(val, 59, &cfg->wake_interval_minutes);
+    } else if (strcasecmp(key, "REFRESH_HOUR") == 0) {
+        ok = parse_uint(val, 23, &cfg->refresh_hour);
+    } else if (strcasecmp(key, "REFRESH_MINUTE") == 0) {
+        ok = parse_uint(val, 59, &cfg->refresh_minute);
+    } else if (strcasecmp(key, "REFRESH_TIME") == 0) {
+        unsigned h = 0, m = 0;
+        ok = sscanf(val, "%u:%u", &h, &m) == 2 && h <= 23 && m <= 59;
+        if (ok) {
+            cfg->refresh_hour = (uint8_t)h;
+            cfg->refresh_minute = (uint8_t)m;
+        }
+    } else {
+        ESP_LOGW(TAG_SD, "Unknown key in config.txt: %s", key);
+        return false;
+    }
+
+    if (!ok) {
+        // Value rejected: the previous value (default) stays in place
+        ESP_LOGW(TAG_SD, "Invalid value for %s, keeping default", key);
     }
-    return false;
+    return ok;
 }
 
-bool sd_config_load_wifi(sd_wifi_config_t *cfg)
+static uint32_t blob_crc(const sd_config_blob_t *b)
+{
+    const uint8_t *start = (const uint8_t *)&b->card_present;
+    size_t len = sizeof(*b) - offsetof(sd_config_blob_t, card_present);
+    return esp_rom_crc32_le(0, start, len);
+}
+
+static bool blob_valid(const sd_config_blob_t *b)
+{
+    return b->version == SD_CONFIG_VERSION &&
+           b->size == sizeof(*b) &&
+           b->crc == blob_crc(b);
+}
+
+/* Power the card, mount FAT and apply the keys of config.txt to cfg. */
+static bool sd_read_config(sd_config_t *cfg)
 {
-    if (!cfg) return false;
-    cfg->ssid = NULL;
-    cfg->password = NULL;
-    bool mounted = false;
     sdmmc_card_t *card = NULL;
 
     sd_power_on();
 
-    if (!sd_card_present()) {
-        ESP_LOGW(TAG_SD, "SD card not detected (card detect low)");
-        sd_power_off();
-        return false;
-    }
-
     sdmmc_host_t host = SDMMC_HOST_DEFAULT();
     host.slot = SDMMC_HOST_SLOT_1;
 
@@ -141,7 +245,17 @@ bool sd_config_load_wifi(sd_wifi_config_t *cfg)
         sd_power_off();
         return false;
     }
-    mounted = true;
+
+#if CONFIG_WAKE_TRACE_SD
+    /* Card is mounted anyway: leave the wake timeline of the last wakes next to config.txt */
+    FILE *trace = fopen(SD_TRACE_FILE, "w");
+    if (trace) {
+        wake_trace_dump_csv(trace);
+        fclose(trace);
+    } else {
+        ESP_LOGW(TAG_SD, "Cannot write %s", SD_TRACE_FILE);
+    }
+#endif
 
     FILE *f = fopen(SD_CONFIG_FILE, "r");
     if (!f) {
@@ -153,21 +267,54 @@ bool sd_config_load_wifi(sd_wifi_config_t *cfg)
 
     char line[256];
     while (fgets(line, sizeof(line), f)) {
-        (void)parse_line(line, &cfg->ssid, &cfg->password);
+        (void)parse_line(line, cfg);
     }
     fclose(f);
 
-    if (mounted) {
-        esp_vfs_fat_sdcard_unmount(SD_MOUNT_POINT, card);
-    }
+    esp_vfs_fat_sdcard_unmount(SD_MOUNT_POINT, card);
     sd_power_off();
+    return true;
+}
+
+bool sd_config_load(bool cold_boot)
+{
+    // Card detect is a mechanical switch against the internal pull-up; no SD power needed
+    bool present = sd_card_present();
 
-    if (cfg->ssid && cfg->ssid[0] != '\0') {
-        ESP_LOGI(TAG_SD, "Loaded Wi-Fi SSID from SD");
-        return true;
+    if (!cold_boot && blob_valid(&s_blob) && s_blob.card_present == present) {
+        s_loaded = true;
+        ESP_LOGI(TAG_SD, "Using cached config (SD card not accessed)");
+        return s_blob.has_config;
     }
 
-    free(cfg->ssid); cfg->ssid = NULL;
-    free(cfg->password); cfg->password = NULL;
-    return false;
+    // memset/memcpy keep padding bytes defined, they are covered by the CRC
+    sd_config_blob_t blob;
+    memset(&blob, 0, sizeof(blob));
+    blob.version = SD_CONFIG_VERSION;
+    blob.size = sizeof(blob);
+    blob.card_present = present;
+    config_defaults(&blob.cfg);
+
+    if (!present) {
+        ESP_LOGW(TAG_SD, "SD card not detected (card detect high)");
+    } else if (sd_read_config(&blob.cfg)) {
+        ESP_LOGI(TAG_SD, "Loaded config.txt (ride '%s', wake every %uh%02um)", blob.cfg.ride_name,
+                 blob.cfg.wake_interval_hours, blob.cfg.wake_interval_minutes);
+        blob.has_config = true;
+    }
+    config_finalize(&blob.cfg);
+    blob.crc = blob_crc(&blob);
+    memcpy(&s_blob, &blob, sizeof(s_blob));
+    s_loaded = true;
+    return blob.has_config;
+}
+
+const sd_config_t *sd_config_get(void)
+{
+    if (s_loaded) return &s_blob.cfg;
+    if (!s_defaults.ride_hash) {
+        config_defaults(&s_defaults);
+        config_finalize(&s_defaults);
+    }
+    return &s_defaults;
 }
@@ -4,22 +4,59 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define SD_CONFIG_VERSION 2
+
+/* GPIO mapping (also used by power.c to isolate the pins in deep sleep) */
+#define SD_PWR_EN_GPIO  GPIO_NUM_2
+#define SD_CD_GPIO      GPIO_NUM_47  /* Card detect (SW) active LOW */
+#define SD_PIN_CLK      GPIO_NUM_39
+#define SD_PIN_CMD      GPIO_NUM_40
+#define SD_PIN_D0       GPIO_NUM_38
+#define SD_PIN_D1       GPIO_NUM_48
+#define SD_PIN_D2       GPIO_NUM_42
+#define SD_PIN_D3       GPIO_NUM_41
+
+/*
+ * Effective device configuration: built-in defaults overridden by the keys
+ * of config.txt, compiled into a fixed layout (no heap strings).
+ *
+ * Keys: WIFI_SSID, WIFI_PASS/WIFI_PASSWORD, PARK_ID, RIDE, TZ,
+ *       WAKE_INTERVAL_HOURS, WAKE_INTERVAL_MINUTES,
+ *       REFRESH_TIME (HH:MM) or REFRESH_HOUR/REFRESH_MINUTE
+ */
 typedef struct {
-    char *ssid;
-    char *password;
-} sd_wifi_config_t;
+    char     ssid[33];              // empty: menuconfig credentials
+    char     password[65];
+    char     park_id[40];
+    char     ride_name[64];
+    char     tz[48];                // POSIX TZ rule, checked when compiled
+    uint8_t  wake_interval_hours;
+    uint8_t  wake_interval_minutes;
+    uint8_t  refresh_hour;
+    uint8_t  refresh_minute;
+
+    /* derived */
+    uint32_t ride_hash;             // ride_table_hash(ride_name)
+} sd_config_t;
 
 /**
- * Attempt to load Wi-Fi credentials from SD card.
- * Returns true on success and fills cfg (caller must free cfg->ssid/password).
- * Returns false on any failure (no card, no file, parse error, etc.).
+ * Load the configuration. On cold boot, or when card detect differs from the
+ * state recorded at the last read, the SD card is powered, mounted and
+ * config.txt is compiled into a versioned, CRC-protected blob in RTC memory.
+ * Otherwise the blob is used and the SD card is not touched.
+ * Returns true if config.txt was found (otherwise defaults apply).
  */
-bool sd_config_load_wifi(sd_wifi_config_t *cfg);
+bool sd_config_load(bool cold_boot);
+
+/* Effective configuration; defaults until sd_config_load() has run. */
+const sd_config_t *sd_config_get(void);
 
 #ifdef __cplusplus
 }
@@ -15,11 +15,23 @@
 #include <time.h>
 #include "esp_log.h"
 #include "sntp_client.h"
+#include "dns_cache.h"
+#include "wake_cycle.h"
+#include "task_pool.h"
 
 #define SNTP_FALLBACK_URL "de.pool.ntp.org"
 
 static const char* TAG_SNTP = "sntp_client";
 
+static char s_ntp_addr[DNS_CACHE_IP_LEN];   // Serveradresse aus dem Resolver-Cache
+
+typedef struct {
+    QueueHandle_t q_print;
+    QueueHandle_t q_rtc;
+} sntp_task_ctx_t;
+
+static sntp_task_ctx_t s_ctx;
+
 // -----------------------------------------------------------------------------
 // Tasks
 // -----------------------------------------------------------------------------
@@ -27,22 +39,27 @@ static const char* TAG_SNTP = "sntp_client";
 // Task: sntp_task (Aktuelle Zeit von einem SNTP Server beziehen)
 static void sntp_task(void* arg)
 {
-    void** pack = (void**)arg;
-    QueueHandle_t out_q_print = (QueueHandle_t)pack[0];
-    QueueHandle_t out_q_rtc = (QueueHandle_t)pack[1];
-    free(pack);
-
-    if (!wifi_conn_wait_ip(pdMS_TO_TICKS(20000))) {
-        ESP_LOGE(TAG_SNTP, "Timeout: keine Wi-Fi Verbindung (waitingtimes)");
-        vTaskDelete(NULL);
+    const sntp_task_ctx_t* ctx = (const sntp_task_ctx_t*)arg;
+    QueueHandle_t out_q_print = ctx->q_print;
+    QueueHandle_t out_q_rtc = ctx->q_rtc;
+
+    if (!wifi_conn_wait_ip(wake_cycle_ticks_left(WAKE_PHASE_WIFI))) {
+        ESP_LOGE(TAG_SNTP, "Timeout: keine Wi-Fi Verbindung (sntp)");
+        wake_cycle_signal(WAKE_EVT_SNTP_DONE);
+        task_pool_exit();
         return;
     }
 
     ESP_LOGI(TAG_SNTP, "Fordere SNTP-Server vom DHCP-Client an (Option 42), setze Fallback auf pool.ntp.org");
 
+    // Fallback-Server per Resolver-Cache auflösen (spart die DNS-Abfrage im Refresh-Wake)
+    bool addr_cached = false;
+    const char* server = dns_cache_resolve(SNTP_FALLBACK_URL, CONFIG_DNS_CACHE_NTP_TTL_S, s_ntp_addr, sizeof(s_ntp_addr), &addr_cached)
+                       ? s_ntp_addr : SNTP_FALLBACK_URL;
+
     // Konfiguration: DHCP erlauben, ABER Fallback-Server mitgeben
     // Hinweis: MULTIPLE nimmt Anzahl + Stringliste; hier 1 Server als Fallback
-    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG_MULTIPLE(1, { SNTP_FALLBACK_URL });
+    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG_MULTIPLE(1, { server });
     cfg.start = false;               // später explizit starten
     cfg.server_from_dhcp = true;     // akzeptiere Option 42, falls vorhanden
     cfg.renew_servers_after_new_IP = true;
@@ -52,57 +69,53 @@ static void sntp_task(void* arg)
     ESP_LOGI(TAG_SNTP, "Starte Zeitabfrage.");
 
     // Warte bis synchronisiert (Timeout evtl. etwas großzügiger wählen)
-    if (esp_netif_sntp_sync_wait(pdMS_TO_TICKS(15000)) != ESP_OK) {
+    esp_err_t sync_err = esp_netif_sntp_sync_wait(wake_cycle_ticks_left(WAKE_PHASE_TIME));
+    if (sync_err != ESP_OK && addr_cached) {
+        ESP_LOGW(TAG_SNTP, "Keine Antwort von gespeicherter Adresse %s, löse %s neu auf", s_ntp_addr, SNTP_FALLBACK_URL);
+        esp_netif_sntp_deinit();
+        dns_cache_invalidate(SNTP_FALLBACK_URL);
+        cfg.servers[0] = SNTP_FALLBACK_URL;
+        esp_netif_sntp_init(&cfg);
+        esp_netif_sntp_start();
+        sync_err = esp_netif_sntp_sync_wait(wake_cycle_ticks_left(WAKE_PHASE_TIME));
+    }
+    if (sync_err != ESP_OK) {
         ESP_LOGE(TAG_SNTP, "Failed to update system time within timeout");
         // Aufräumen
         esp_netif_sntp_deinit();
-        vTaskDelete(NULL);
+        wake_cycle_signal(WAKE_EVT_SNTP_DONE);
+        task_pool_exit();
         return;
     }
 
-   
-    time_t now;
-
-    struct tm* tm_local_ptr = (struct tm*) calloc(1,sizeof(struct tm));
-    struct tm* tm_utc_ptr = (struct tm*) calloc(1,sizeof(struct tm));
-
-    setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
-    tzset();
+    wifi_conn_traffic_ok();
 
-    time(&now);
+    time_data_t time_data;
+    time(&time_data.now);
 
-    localtime_r(&now, tm_local_ptr);
-    gmtime_r(&now, tm_utc_ptr);
+    struct tm tm_local;
+    localtime_r(&time_data.now, &tm_local);
 
     char buf[64];
-    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %Z", tm_local_ptr);
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %Z", &tm_local);
     ESP_LOGI(TAG_SNTP, "Zeit gesetzt auf: %s", buf);
 
-    time_data_t* time_struct = calloc(1, sizeof(*time_struct));
-
-    time_struct->time_local = tm_local_ptr;
-    time_struct->time_utc = tm_utc_ptr;
-
+    // Jede Queue bekommt ihre eigene Kopie
     if (out_q_print) {
-        if (xQueueSend(out_q_print, &time_struct, pdMS_TO_TICKS(100)) != pdPASS) {
+        if (xQueueSend(out_q_print, &time_data, pdMS_TO_TICKS(100)) != pdPASS) {
             ESP_LOGW(TAG_SNTP, "time-Queue voll, Wert nicht gesendet.");
-            //free(park->open_from); free(park->closed_from); free(park);
         }
-    } else {
-        //free(park->open_from); free(park->closed_from); free(park);
     }
 
     if (out_q_rtc) {
-        if (xQueueSend(out_q_rtc, &time_struct, pdMS_TO_TICKS(100)) != pdPASS) {
+        if (xQueueSend(out_q_rtc, &time_data, pdMS_TO_TICKS(100)) != pdPASS) {
             ESP_LOGW(TAG_SNTP, "time-Queue voll, Wert nicht gesendet.");
-            //free(park->open_from); free(park->closed_from); free(park);
         }
-    } else {
-        //free(park->open_from); free(park->closed_from); free(park);
     }
 
     esp_netif_sntp_deinit();
-    vTaskDelete(NULL);
+    wake_cycle_signal(WAKE_EVT_SNTP_DONE);
+    task_pool_exit();
 }
 
 
@@ -111,9 +124,8 @@ static void sntp_task(void* arg)
 // -----------------------------------------------------------------------------
 void start_sntp_task(QueueHandle_t out_queue_print, QueueHandle_t out_queue_rtc)
 {
-    void** pack = calloc(2, sizeof(void*));
-    pack[0] = (void*)out_queue_print;
-    pack[1] = (void*)out_queue_rtc;
+    s_ctx.q_print = out_queue_print;
+    s_ctx.q_rtc = out_queue_rtc;
 
-    xTaskCreate(sntp_task, "sntp_task", 8192, pack, 5, NULL);
+    task_pool_start(TASK_POOL_SNTP, sntp_task, &s_ctx);
 }
@@ -8,9 +8,9 @@
 extern "C" {
 #endif
 
+/* Aktuelle Zeit als Wert; Lokalzeit per localtime_r (TZ ist gesetzt) */
 typedef struct {
-    struct tm* time_local;
-    struct tm* time_utc;
+    time_t now;
 } time_data_t;
 
 void start_sntp_task(QueueHandle_t out_queue_print, QueueHandle_t out_queue_rtc);
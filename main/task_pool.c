@@ -0,0 +1,112 @@
+// ==============================================
+// File: main/task_pool.c
+// ==============================================
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+#include "task_pool.h"
+
+static const char* TAG_POOL = "task_pool";
+
+// Wi-Fi/lwIP laufen auf Core 0, Rechenarbeit (TLS, LVGL) auf Core 1
+#define TASK_CORE_PRO   0
+#define TASK_CORE_APP   (portNUM_PROCESSORS > 1 ? 1 : 0)
+
+// Stackgrößen in Bytes wie bisher bei xTaskCreate; vor dem Verkleinern die
+// Reserve aus task_pool_report prüfen. Zusammen 28 KB, die als statische Arrays
+// dauerhaft im internen DRAM liegen (auch wenn der Task gerade nicht läuft).
+#define API_FETCH_STACK 8192    // mbedTLS-Handshake, gzip, Stream-Parser
+#define PRINT_STACK     4096    // LVGL-Rendern
+#define SNTP_STACK      8192
+#define RTC_STACK       8192
+
+static StackType_t s_stack_api[API_FETCH_STACK];
+static StackType_t s_stack_print[PRINT_STACK];
+static StackType_t s_stack_sntp[SNTP_STACK];
+static StackType_t s_stack_rtc[RTC_STACK];
+
+typedef struct {
+    const char  *name;
+    StackType_t *stack;
+    uint32_t     stack_size;
+    UBaseType_t  prio;
+    BaseType_t   core;
+} task_def_t;
+
+static const task_def_t s_defs[TASK_POOL_COUNT] = {
+    [TASK_POOL_API_FETCH] = { "api_fetch_task", s_stack_api,   sizeof(s_stack_api),   5, TASK_CORE_APP },
+    [TASK_POOL_PRINT]     = { "print_task",     s_stack_print, sizeof(s_stack_print), 5, TASK_CORE_APP },
+    [TASK_POOL_SNTP]      = { "sntp_task",      s_stack_sntp,  sizeof(s_stack_sntp),  5, TASK_CORE_PRO },
+    [TASK_POOL_RTC]       = { "rtc_task",       s_stack_rtc,   sizeof(s_stack_rtc),   5, TASK_CORE_PRO },
+};
+
+typedef struct {
+    StaticTask_t tcb;
+    TaskHandle_t handle;
+    bool         started;       // in diesem Wake gestartet
+    bool         running;
+    uint32_t     min_free;      // Stack-Reserve beim Beenden (Bytes)
+} task_slot_t;
+
+static task_slot_t s_slots[TASK_POOL_COUNT];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Kleinste Reserve über Deep Sleep hinweg, 0 = noch nicht gemessen
+static RTC_DATA_ATTR uint16_t s_min_free_ever[TASK_POOL_COUNT];
+
+bool task_pool_start(task_pool_id_t id, TaskFunction_t fn, void *ctx)
+{
+    if (id >= TASK_POOL_COUNT || !fn) return false;
+    const task_def_t *def = &s_defs[id];
+    task_slot_t *slot = &s_slots[id];
+
+    taskENTER_CRITICAL(&s_lock);
+    bool busy = slot->running;
+    slot->running = true;
+    taskEXIT_CRITICAL(&s_lock);
+    if (busy) {
+        ESP_LOGE(TAG_POOL, "%s läuft noch, nicht erneut gestartet", def->name);
+        return false;
+    }
+
+    slot->started = true;
+    slot->min_free = 0;
+    slot->handle = xTaskCreateStaticPinnedToCore(fn, def->name, def->stack_size, ctx, def->prio,
+                                                 def->stack, &slot->tcb, def->core);
+    return slot->handle != NULL;
+}
+
+void task_pool_exit(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < TASK_POOL_COUNT; i++) {
+        task_slot_t *slot = &s_slots[i];
+        if (slot->handle != self) continue;
+        slot->min_free = uxTaskGetStackHighWaterMark(NULL);
+        taskENTER_CRITICAL(&s_lock);
+        slot->running = false;
+        taskEXIT_CRITICAL(&s_lock);
+        break;
+    }
+    vTaskDelete(NULL);
+}
+
+void task_pool_report(void)
+{
+    for (int i = 0; i < TASK_POOL_COUNT; i++) {
+        task_slot_t *slot = &s_slots[i];
+        if (!slot->started) continue;
+
+        // Noch laufend (Budget überschritten): aktuellen Stand nehmen
+        uint32_t free_b = slot->running ? uxTaskGetStackHighWaterMark(slot->handle) : slot->min_free;
+        if (!s_min_free_ever[i] || free_b < s_min_free_ever[i]) {
+            s_min_free_ever[i] = free_b > UINT16_MAX ? UINT16_MAX : free_b;
+        }
+        ESP_LOGI(TAG_POOL, "%s: Stack min. %lu von %lu Bytes frei (seit Kaltstart min. %u)%s",
+                 s_defs[i].name, (unsigned long)free_b, (unsigned long)s_defs[i].stack_size,
+                 s_min_free_ever[i], slot->running ? " [läuft noch]" : "");
+    }
+}
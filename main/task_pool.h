@@ -0,0 +1,40 @@
+// ==============================================
+// File: main/task_pool.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Feste Tasks eines Wakes mit statischem TCB und Stack im internen DRAM,
+ * Priorität und Core pro Task aus einer Tabelle. Jeder Task läuft höchstens
+ * einmal gleichzeitig und beendet sich mit task_pool_exit(), das die
+ * Stack-Reserve für das Log festhält.
+ */
+
+typedef enum {
+    TASK_POOL_API_FETCH = 0,
+    TASK_POOL_PRINT,
+    TASK_POOL_SNTP,
+    TASK_POOL_RTC,
+    TASK_POOL_COUNT
+} task_pool_id_t;
+
+/* Task starten; ctx zeigt auf den statischen Kontext des Moduls.
+ * false, wenn der Task noch läuft. */
+bool task_pool_start(task_pool_id_t id, TaskFunction_t fn, void *ctx);
+
+/* Statt vTaskDelete(NULL) am Ende eines Pool-Tasks. */
+void task_pool_exit(void);
+
+/* Minimale Stack-Reserve pro Task loggen (direkt vor dem Deep Sleep). */
+void task_pool_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,234 @@
+// ==============================================
+// File: main/wake_arena.c
+// ==============================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "cJSON.h"
+
+#include "wake_arena.h"
+
+static const char* TAG_ARENA = "wake_arena";
+
+#define ARENA_ALIGN         8
+#define ARENA_ALIGN_UP(n)   (((n) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_MAGIC         0x41524e41u     // "ARNA"
+
+#define ARENA_INTERNAL_SIZE (CONFIG_WAKE_ARENA_INTERNAL_KB * 1024)
+#define ARENA_PSRAM_SIZE    (CONFIG_WAKE_ARENA_PSRAM_KB * 1024)
+
+// Vor jedem Block: Größe für realloc, Magic gegen fremde Zeiger
+typedef struct {
+    uint32_t size;
+    uint32_t magic;
+} arena_hdr_t;
+
+typedef struct {
+    uint8_t *base;
+    size_t   cap;
+    size_t   top;           // belegt, inkl. Header
+    size_t   high;          // Höchststand in diesem Wake
+} arena_t;
+
+// Höchststand über Deep Sleep, zum Dimensionieren der Arenen
+typedef struct {
+    uint32_t max_high[WAKE_ARENA_COUNT];
+} arena_stats_t;
+
+static RTC_DATA_ATTR arena_stats_t s_stats;
+
+static uint8_t s_internal_mem[ARENA_INTERNAL_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+static arena_t s_arena[WAKE_ARENA_COUNT];
+static uint32_t s_fallback_count;
+static size_t   s_fallback_bytes;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const s_arena_names[WAKE_ARENA_COUNT] = {
+    [WAKE_ARENA_INTERNAL] = "intern",
+    [WAKE_ARENA_PSRAM]    = "PSRAM",
+};
+
+static uint32_t arena_caps(wake_arena_id_t id)
+{
+    return id == WAKE_ARENA_PSRAM ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+                                  : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+static arena_t *arena_of(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (int i = 0; i < WAKE_ARENA_COUNT; i++) {
+        arena_t *a = &s_arena[i];
+        if (a->base && p > a->base && p < a->base + a->cap) return a;
+    }
+    return NULL;
+}
+
+static arena_hdr_t *hdr_of(void *ptr)
+{
+    return (arena_hdr_t *)((uint8_t *)ptr - sizeof(arena_hdr_t));
+}
+
+static void *arena_bump(arena_t *a, size_t size)
+{
+    size_t need = sizeof(arena_hdr_t) + ARENA_ALIGN_UP(size);
+    uint8_t *p = NULL;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (a->base && a->cap - a->top >= need) {
+        p = a->base + a->top;
+        a->top += need;
+        if (a->top > a->high) a->high = a->top;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!p) return NULL;
+    arena_hdr_t *h = (arena_hdr_t *)p;
+    h->size = (uint32_t)size;
+    h->magic = ARENA_MAGIC;
+    return p + sizeof(*h);
+}
+
+// Arena voll oder nicht vorhanden: normaler Heap mit passenden Caps
+static void *heap_fallback(wake_arena_id_t id, size_t size)
+{
+    void *p = heap_caps_malloc(size, arena_caps(id));
+    if (!p) p = malloc(size);
+    if (p) {
+        taskENTER_CRITICAL(&s_lock);
+        s_fallback_count++;
+        s_fallback_bytes += size;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+    return p;
+}
+
+static void *cjson_malloc(size_t size)
+{
+    return wake_arena_alloc(WAKE_ARENA_PSRAM, size);
+}
+
+void wake_arena_init(void)
+{
+    arena_t *in = &s_arena[WAKE_ARENA_INTERNAL];
+    in->base = s_internal_mem;
+    in->cap = sizeof(s_internal_mem);
+
+    arena_t *ps = &s_arena[WAKE_ARENA_PSRAM];
+    if (!ps->base && ARENA_PSRAM_SIZE > 0) {
+        ps->base = heap_caps_malloc(ARENA_PSRAM_SIZE, arena_caps(WAKE_ARENA_PSRAM));
+        ps->cap = ps->base ? ARENA_PSRAM_SIZE : 0;
+        if (!ps->base) ESP_LOGW(TAG_ARENA, "Keine PSRAM-Arena, große Puffer kommen vom Heap");
+    }
+
+    for (int i = 0; i < WAKE_ARENA_COUNT; i++) {
+        s_arena[i].top = 0;
+        s_arena[i].high = 0;
+    }
+    s_fallback_count = 0;
+    s_fallback_bytes = 0;
+
+    // cJSON gibt Knoten einzeln frei -> bis auf den letzten Block No-op
+    cJSON_Hooks hooks = { .malloc_fn = cjson_malloc, .free_fn = wake_arena_free };
+    cJSON_InitHooks(&hooks);
+}
+
+void *wake_arena_alloc(wake_arena_id_t arena, size_t size)
+{
+    if (arena >= WAKE_ARENA_COUNT) arena = WAKE_ARENA_INTERNAL;
+    void *p = arena_bump(&s_arena[arena], size);
+    return p ? p : heap_fallback(arena, size);
+}
+
+void *wake_arena_calloc(wake_arena_id_t arena, size_t n, size_t size)
+{
+    if (size && n > SIZE_MAX / size) return NULL;
+    void *p = wake_arena_alloc(arena, n * size);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void *wake_arena_realloc(wake_arena_id_t arena, void *ptr, size_t size)
+{
+    if (!ptr) return wake_arena_alloc(arena, size);
+    if (size == 0) { wake_arena_free(ptr); return NULL; }
+
+    arena_t *a = arena_of(ptr);
+    if (!a) return heap_caps_realloc(ptr, size, arena_caps(arena));
+
+    // Letzter Block (typisch: wachsender HTTP-Puffer) wächst an Ort und Stelle
+    arena_hdr_t *h = hdr_of(ptr);
+    size_t old = h->size;
+    size_t start = (uint8_t *)ptr - a->base;
+    bool in_place = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (start + ARENA_ALIGN_UP(old) == a->top && a->cap - start >= ARENA_ALIGN_UP(size)) {
+        a->top = start + ARENA_ALIGN_UP(size);
+        if (a->top > a->high) a->high = a->top;
+        h->size = (uint32_t)size;
+        in_place = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (in_place) return ptr;
+
+    void *np = wake_arena_alloc(arena, size);
+    if (!np) return NULL;
+    memcpy(np, ptr, old < size ? old : size);
+    wake_arena_free(ptr);
+    return np;
+}
+
+char *wake_arena_strdup(wake_arena_id_t arena, const char *s)
+{
+    if (!s) return NULL;
+    size_t len = strlen(s) + 1;
+    char *p = wake_arena_alloc(arena, len);
+    if (p) memcpy(p, s, len);
+    return p;
+}
+
+void wake_arena_free(void *ptr)
+{
+    if (!ptr) return;
+    arena_t *a = arena_of(ptr);
+    if (!a) {
+        heap_caps_free(ptr);
+        return;
+    }
+
+    arena_hdr_t *h = hdr_of(ptr);
+    if (h->magic != ARENA_MAGIC) {
+        ESP_LOGE(TAG_ARENA, "free: ungültiger Zeiger %p", ptr);
+        return;
+    }
+    size_t start = (uint8_t *)ptr - a->base;
+
+    // Nur der oberste Block geht zurück; alles andere räumt der nächste Wake ab
+    taskENTER_CRITICAL(&s_lock);
+    if (start + ARENA_ALIGN_UP(h->size) == a->top) {
+        a->top = start - sizeof(arena_hdr_t);
+        h->magic = 0;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void wake_arena_report(void)
+{
+    for (int i = 0; i < WAKE_ARENA_COUNT; i++) {
+        const arena_t *a = &s_arena[i];
+        if (a->high > s_stats.max_high[i]) s_stats.max_high[i] = a->high;
+        ESP_LOGI(TAG_ARENA, "Arena %s: max %u von %u Bytes (seit Kaltstart max %lu)",
+                 s_arena_names[i], (unsigned)a->high, (unsigned)a->cap, (unsigned long)s_stats.max_high[i]);
+    }
+    if (s_fallback_count) {
+        ESP_LOGW(TAG_ARENA, "%lu Anforderungen (%u Bytes) vom Heap statt aus der Arena",
+                 (unsigned long)s_fallback_count, (unsigned)s_fallback_bytes);
+    }
+}
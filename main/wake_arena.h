@@ -0,0 +1,43 @@
+// ==============================================
+// File: main/wake_arena.h
+// ==============================================
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bump-Allocator für alles, was nur einen Wake lang lebt (Stream-Parser,
+ * HTTP-Puffer, gzip-Decoder, cJSON-Knoten). Zwei Arenen: interner SRAM für
+ * kleine, oft benutzte Objekte, PSRAM für große Puffer. Freigeben ist
+ * billig: nur der jeweils letzte Block wird zurückgenommen, der Rest fällt
+ * mit dem Deep Sleep weg. Ist eine Arena voll, geht die Anforderung an den
+ * normalen Heap; wake_arena_free erkennt das selbst.
+ */
+
+typedef enum {
+    WAKE_ARENA_INTERNAL = 0,    // statischer Puffer im internen DRAM
+    WAKE_ARENA_PSRAM,           // einmal aus dem PSRAM geholt
+    WAKE_ARENA_COUNT
+} wake_arena_id_t;
+
+/* Arenen anlegen bzw. leeren und cJSON auf die PSRAM-Arena umstellen.
+ * Einmal pro Wake, bevor Tasks gestartet werden. */
+void  wake_arena_init(void);
+
+void *wake_arena_alloc(wake_arena_id_t arena, size_t size);
+void *wake_arena_calloc(wake_arena_id_t arena, size_t n, size_t size);
+void *wake_arena_realloc(wake_arena_id_t arena, void *ptr, size_t size);
+char *wake_arena_strdup(wake_arena_id_t arena, const char *s);
+
+/* Beliebiger Zeiger aus wake_arena_* (auch NULL und Heap-Ersatz). */
+void  wake_arena_free(void *ptr);
+
+/* Höchststand pro Arena und Heap-Ersatz loggen (direkt vor dem Deep Sleep). */
+void  wake_arena_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+// ==============================================
+// File: main/wake_cycle.c
+// ==============================================
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "wake_cycle.h"
+
+static const char* TAG_WAKE = "wake_cycle";
+
+// Deadlines ab Wake-Beginn; alle werden auf das Gesamtbudget begrenzt
+static const uint32_t s_deadline_ms[WAKE_PHASE_COUNT] = {
+    [WAKE_PHASE_WIFI]    = 8000,
+    [WAKE_PHASE_FETCH]   = 15000,
+    [WAKE_PHASE_TIME]    = 15000,
+    [WAKE_PHASE_DISPLAY] = CONFIG_WAKE_BUDGET_MS,
+};
+
+static const char* const s_outcome_names[WAKE_OUTCOME_COUNT] = {
+    [WAKE_OUTCOME_OK]        = "ok",
+    [WAKE_OUTCOME_UNCHANGED] = "unverändert",
+    [WAKE_OUTCOME_NO_DATA]   = "keine Daten",
+    [WAKE_OUTCOME_TIMEOUT]   = "Timeout",
+};
+
+// Über Deep Sleep: Zähler pro Ergebnis und der letzte Datensatz
+typedef struct {
+    uint32_t      wakes;
+    uint32_t      outcomes[WAKE_OUTCOME_COUNT];
+    uint16_t      max_total_ms;
+    wake_record_t last;
+} wake_stats_t;
+
+static RTC_DATA_ATTR wake_stats_t s_stats;
+
+static EventGroupHandle_t s_evt;
+static int64_t s_start_us;
+static wake_record_t s_rec;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t elapsed_ms(void)
+{
+    return (uint32_t)((esp_timer_get_time() - s_start_us) / 1000);
+}
+
+void wake_cycle_begin(bool cold_boot)
+{
+    if (!s_evt) s_evt = xEventGroupCreate();
+    configASSERT(s_evt);
+    xEventGroupClearBits(s_evt, 0x00FFFFFF);
+
+    s_start_us = esp_timer_get_time();
+    memset(&s_rec, 0, sizeof(s_rec));
+    s_rec.seq = s_stats.wakes + 1;
+    s_rec.cold_boot = cold_boot;
+    s_rec.outcome = WAKE_OUTCOME_OK;
+}
+
+TickType_t wake_cycle_ticks_left(wake_phase_t phase)
+{
+    uint32_t deadline = s_deadline_ms[phase];
+    if (deadline > CONFIG_WAKE_BUDGET_MS) deadline = CONFIG_WAKE_BUDGET_MS;
+    uint32_t now = elapsed_ms();
+    return now >= deadline ? 0 : pdMS_TO_TICKS(deadline - now);
+}
+
+void wake_cycle_signal(EventBits_t bits)
+{
+    if (s_evt) xEventGroupSetBits(s_evt, bits);
+}
+
+bool wake_cycle_wait(EventBits_t bits, wake_phase_t phase)
+{
+    if (!s_evt) return false;
+    EventBits_t got = xEventGroupWaitBits(s_evt, bits, pdFALSE, pdTRUE, wake_cycle_ticks_left(phase));
+    return (got & bits) == bits;
+}
+
+bool wake_cycle_done(EventBits_t bits)
+{
+    return s_evt && (xEventGroupGetBits(s_evt) & bits) == bits;
+}
+
+void wake_cycle_mark(wake_phase_t phase)
+{
+    uint32_t ms = elapsed_ms();
+    taskENTER_CRITICAL(&s_lock);
+    if (!s_rec.phase_ms[phase]) s_rec.phase_ms[phase] = ms > UINT16_MAX ? UINT16_MAX : (ms ? ms : 1);
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void wake_cycle_set_outcome(wake_outcome_t outcome)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (outcome > s_rec.outcome) s_rec.outcome = outcome;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+const wake_record_t *wake_cycle_finish(void)
+{
+    uint32_t ms = elapsed_ms();
+    s_rec.total_ms = ms > UINT16_MAX ? UINT16_MAX : ms;
+
+    s_stats.wakes++;
+    s_stats.outcomes[s_rec.outcome]++;
+    if (s_rec.total_ms > s_stats.max_total_ms) s_stats.max_total_ms = s_rec.total_ms;
+    s_stats.last = s_rec;
+
+    ESP_LOGI(TAG_WAKE, "Wake #%lu: %s nach %u ms (wifi %u, fetch %u, zeit %u, display %u)%s",
+             (unsigned long)s_rec.seq, s_outcome_names[s_rec.outcome], s_rec.total_ms,
+             s_rec.phase_ms[WAKE_PHASE_WIFI], s_rec.phase_ms[WAKE_PHASE_FETCH],
+             s_rec.phase_ms[WAKE_PHASE_TIME], s_rec.phase_ms[WAKE_PHASE_DISPLAY],
+             s_rec.cold_boot ? " [Kaltstart]" : "");
+    ESP_LOGI(TAG_WAKE, "Seit Kaltstart: %lu ok / %lu unverändert / %lu ohne Daten / %lu Timeout, max %u ms",
+             (unsigned long)s_stats.outcomes[WAKE_OUTCOME_OK], (unsigned long)s_stats.outcomes[WAKE_OUTCOME_UNCHANGED],
+             (unsigned long)s_stats.outcomes[WAKE_OUTCOME_NO_DATA], (unsigned long)s_stats.outcomes[WAKE_OUTCOME_TIMEOUT],
+             s_stats.max_total_ms);
+    return &s_stats.last;
+}
@@ -0,0 +1,74 @@
+// ==============================================
+// File: main/wake_cycle.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Ablaufsteuerung eines Wakes: gemeinsames Zeitbudget, Deadline pro Phase,
+ * Event-Group für "Task fertig" (auch bei Fehler) und ein Ergebnis-Datensatz
+ * pro Wake in RTC-Memory. Tasks warten nie länger als bis zur Deadline ihrer
+ * Phase; main geht schlafen, sobald das Ergebnis feststeht.
+ */
+
+// Fertig-Bits, werden auch bei Fehlschlag gesetzt
+#define WAKE_EVT_API_DONE       BIT0
+#define WAKE_EVT_SNTP_DONE      BIT1
+#define WAKE_EVT_RTC_DONE       BIT2
+#define WAKE_EVT_DISPLAY_DONE   BIT3
+
+typedef enum {
+    WAKE_PHASE_WIFI = 0,    // bis IP
+    WAKE_PHASE_FETCH,       // API-Daten in den Queues
+    WAKE_PHASE_TIME,        // aktuelle Zeit (RTC oder SNTP)
+    WAKE_PHASE_DISPLAY,     // Panel aktualisiert = Ende des Budgets
+    WAKE_PHASE_COUNT
+} wake_phase_t;
+
+typedef enum {
+    WAKE_OUTCOME_OK = 0,        // neue Daten angezeigt
+    WAKE_OUTCOME_UNCHANGED,     // Server ohne Änderung, Anzeige bleibt
+    WAKE_OUTCOME_NO_DATA,       // Abruf fehlgeschlagen, Anzeige bleibt
+    WAKE_OUTCOME_TIMEOUT,       // Budget überschritten
+    WAKE_OUTCOME_COUNT
+} wake_outcome_t;
+
+typedef struct {
+    uint32_t seq;
+    uint8_t  outcome;                       // wake_outcome_t
+    bool     cold_boot;
+    uint16_t total_ms;
+    uint16_t phase_ms[WAKE_PHASE_COUNT];    // Zeitpunkt des Phasenendes, 0 = nicht erreicht
+} wake_record_t;
+
+void wake_cycle_begin(bool cold_boot);
+
+/* Verbleibende Ticks bis zur Deadline der Phase (0, wenn abgelaufen). */
+TickType_t wake_cycle_ticks_left(wake_phase_t phase);
+
+/* Fertig-Bits setzen bzw. bis zur Deadline der Phase auf alle bits warten. */
+void wake_cycle_signal(EventBits_t bits);
+bool wake_cycle_wait(EventBits_t bits, wake_phase_t phase);
+
+/* Sind alle bits bereits gesetzt? (ohne zu warten) */
+bool wake_cycle_done(EventBits_t bits);
+
+/* Ende einer Phase festhalten (nur der erste Aufruf zählt). */
+void wake_cycle_mark(wake_phase_t phase);
+
+/* Ergebnis melden; es gilt das schlechteste gemeldete. */
+void wake_cycle_set_outcome(wake_outcome_t outcome);
+
+/* Datensatz abschließen, in RTC-Memory ablegen und loggen (direkt vor dem Deep Sleep). */
+const wake_record_t *wake_cycle_finish(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,178 @@
+// ==============================================
+// File: main/wake_trace.c
+// ==============================================
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "wake_trace.h"
+
+#if CONFIG_WAKE_TRACE
+
+static const char* TAG_TRACE = "wake_trace";
+
+#define TRACE_MAGIC     0x54524331u     // "TRC1"
+#define TRACE_EVENTS    48              // Ereignisse pro Wake, Rest wird gezählt und verworfen
+
+// Ereignis in 32 Bit: Bit 31 Ende, Bits 26..30 Abschnitt, Bits 0..25 µs (max. ~67 s)
+#define TRACE_EV_END        (1u << 31)
+#define TRACE_EV_PHASE_SHIFT 26
+#define TRACE_EV_US_MASK    ((1u << TRACE_EV_PHASE_SHIFT) - 1)
+
+_Static_assert(TRACE_PHASE_COUNT <= 32, "Abschnitts-ID passt nicht in 5 Bit");
+
+typedef struct {
+    uint32_t seq;
+    uint8_t  count;
+    uint8_t  dropped;
+    bool     cold_boot;
+    bool     complete;          // bis zum Deep Sleep aufgezeichnet
+    uint32_t ev[TRACE_EVENTS];
+} trace_wake_t;
+
+typedef struct {
+    uint32_t     magic;
+    uint16_t     size;          // Layout-Prüfung nach Firmware-Update
+    uint16_t     head;          // nächster zu beschreibender Eintrag
+    uint32_t     seq;
+    trace_wake_t wakes[CONFIG_WAKE_TRACE_WAKES];
+} trace_ring_t;
+
+// Nicht initialisiert: übersteht Deep Sleep und Software-Reset, nach Power-On Zufallswerte
+static RTC_NOINIT_ATTR trace_ring_t s_ring;
+static trace_wake_t *s_cur;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const s_phase_names[TRACE_PHASE_COUNT] = {
+    [TRACE_WAKE]              = "wake",
+    [TRACE_BOOT]              = "boot",
+    [TRACE_NVS]               = "nvs",
+    [TRACE_SD_CONFIG]         = "sd_config",
+    [TRACE_WIFI_ASSOC]        = "wifi_assoc",
+    [TRACE_WIFI_DHCP]         = "wifi_dhcp",
+    [TRACE_DNS]               = "dns",
+    [TRACE_TLS]               = "tls",
+    [TRACE_HTTP_OPENINGTIMES] = "http_openingtimes",
+    [TRACE_HTTP_WAITINGTIMES] = "http_waitingtimes",
+    [TRACE_JSON_PARSE]        = "json_parse",
+    [TRACE_RTC_READ]          = "rtc_read",
+    [TRACE_RTC_SET]           = "rtc_set",
+    [TRACE_LVGL_RENDER]       = "lvgl_render",
+    [TRACE_EPD_SPI]           = "epd_spi",
+    [TRACE_EPD_BUSY]          = "epd_busy",
+    [TRACE_RTC_ALARM]         = "rtc_alarm",
+};
+
+static bool ring_valid(void)
+{
+    return s_ring.magic == TRACE_MAGIC &&
+           s_ring.size == sizeof(s_ring) &&
+           s_ring.head < CONFIG_WAKE_TRACE_WAKES;
+}
+
+static void record(trace_phase_t phase, uint32_t us, bool end)
+{
+    if (us > TRACE_EV_US_MASK) us = TRACE_EV_US_MASK;
+    uint32_t ev = (end ? TRACE_EV_END : 0) | ((uint32_t)phase << TRACE_EV_PHASE_SHIFT) | us;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_cur) {
+        if (s_cur->count < TRACE_EVENTS) {
+            s_cur->ev[s_cur->count++] = ev;
+        } else if (s_cur->dropped < UINT8_MAX) {
+            s_cur->dropped++;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void wake_trace_begin_wake(bool cold_boot)
+{
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    if (!ring_valid()) {
+        memset(&s_ring, 0, sizeof(s_ring));
+        s_ring.magic = TRACE_MAGIC;
+        s_ring.size = sizeof(s_ring);
+    }
+
+    trace_wake_t *w = &s_ring.wakes[s_ring.head];
+    memset(w, 0, sizeof(*w));
+    w->seq = ++s_ring.seq;
+    w->cold_boot = cold_boot;
+    s_ring.head = (s_ring.head + 1) % CONFIG_WAKE_TRACE_WAKES;
+    s_cur = w;
+
+    // Zeit vor app_main (Bootloader, Init) beginnt bei 0
+    record(TRACE_WAKE, 0, false);
+    record(TRACE_BOOT, 0, false);
+    record(TRACE_BOOT, now, true);
+}
+
+void wake_trace_begin(trace_phase_t phase)
+{
+    record(phase, (uint32_t)esp_timer_get_time(), false);
+}
+
+void wake_trace_end(trace_phase_t phase)
+{
+    record(phase, (uint32_t)esp_timer_get_time(), true);
+}
+
+void wake_trace_finish(void)
+{
+    if (!s_cur) return;
+    wake_trace_end(TRACE_WAKE);
+    taskENTER_CRITICAL(&s_lock);
+    s_cur->complete = true;
+    taskEXIT_CRITICAL(&s_lock);
+    if (s_cur->dropped) {
+        ESP_LOGW(TAG_TRACE, "Wake #%lu: %u Trace-Ereignisse verworfen",
+                 (unsigned long)s_cur->seq, s_cur->dropped);
+    }
+}
+
+// Ereignisse eines Wakes zu Abschnitten paaren: jedes Ende gehört zum letzten
+// offenen Beginn derselben ID, Ende ohne Beginn (z.B. wiederverwendete Verbindung) fällt weg
+static void dump_wake(FILE *f, const trace_wake_t *w)
+{
+    int64_t open_us[TRACE_PHASE_COUNT];
+    for (int p = 0; p < TRACE_PHASE_COUNT; p++) open_us[p] = -1;
+
+    unsigned count = w->count <= TRACE_EVENTS ? w->count : TRACE_EVENTS;
+    for (unsigned i = 0; i < count; i++) {
+        uint32_t ev = w->ev[i];
+        unsigned phase = (ev >> TRACE_EV_PHASE_SHIFT) & 0x1F;
+        uint32_t us = ev & TRACE_EV_US_MASK;
+        if (phase >= TRACE_PHASE_COUNT) continue;
+
+        if (!(ev & TRACE_EV_END)) {
+            open_us[phase] = us;
+        } else if (open_us[phase] >= 0) {
+            fprintf(f, "%lu,%d,%s,%lu,%lu\n", (unsigned long)w->seq, w->cold_boot ? 1 : 0,
+                    s_phase_names[phase], (unsigned long)open_us[phase],
+                    (unsigned long)(us - (uint32_t)open_us[phase]));
+            open_us[phase] = -1;
+        }
+    }
+    if (w->dropped) fprintf(f, "# seq %lu: %u Ereignisse verworfen\n", (unsigned long)w->seq, w->dropped);
+}
+
+void wake_trace_dump_csv(FILE *f)
+{
+    if (!f || !ring_valid()) return;
+
+    fprintf(f, "seq,cold,phase,start_us,dur_us\n");
+    // Ältester Eintrag zuerst
+    for (int i = 0; i < CONFIG_WAKE_TRACE_WAKES; i++) {
+        const trace_wake_t *w = &s_ring.wakes[(s_ring.head + i) % CONFIG_WAKE_TRACE_WAKES];
+        if (w->complete) dump_wake(f, w);
+    }
+    fflush(f);
+}
+
+#endif
@@ -0,0 +1,67 @@
+// ==============================================
+// File: main/wake_trace.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Zeitleiste pro Wake: Beginn/Ende einzelner Abschnitte (esp_timer, µs seit
+ * Boot) in einem RTC_NOINIT-Ringpuffer über die letzten Wakes. Übersteht
+ * Deep Sleep und Reset, nicht aber Stromverlust. Ausgabe als CSV
+ * (seq,cold,phase,start_us,dur_us), auswertbar mit tools/wake_trace_stats.py.
+ */
+
+typedef enum {
+    TRACE_WAKE = 0,             // gesamter Wake bis Deep Sleep
+    TRACE_BOOT,                 // Reset bis app_main
+    TRACE_NVS,                  // NVS, netif, Event-Loop
+    TRACE_SD_CONFIG,
+    TRACE_WIFI_ASSOC,           // esp_wifi_start bis verbunden
+    TRACE_WIFI_DHCP,            // verbunden bis IP
+    TRACE_DNS,
+    TRACE_TLS,                  // Request-Start bis TLS-Verbindung steht
+    TRACE_HTTP_OPENINGTIMES,
+    TRACE_HTTP_WAITINGTIMES,    // inkl. Stream-Parser
+    TRACE_JSON_PARSE,           // cJSON Openingtimes
+    TRACE_RTC_READ,
+    TRACE_RTC_SET,              // SNTP-Zeit in die RTC schreiben
+    TRACE_LVGL_RENDER,
+    TRACE_EPD_SPI,              // Bilddaten zum Panel
+    TRACE_EPD_BUSY,             // Warten auf BUSY low
+    TRACE_RTC_ALARM,            // nächsten Alarm stellen
+    TRACE_PHASE_COUNT
+} trace_phase_t;
+
+#if CONFIG_WAKE_TRACE
+
+/* Neuen Eintrag im Ring beginnen (erster Aufruf in app_main). */
+void wake_trace_begin_wake(bool cold_boot);
+
+void wake_trace_begin(trace_phase_t phase);
+void wake_trace_end(trace_phase_t phase);
+
+/* Eintrag als vollständig markieren (direkt vor dem Deep Sleep). */
+void wake_trace_finish(void);
+
+/* Alle vollständigen Wakes als CSV nach f schreiben. */
+void wake_trace_dump_csv(FILE *f);
+
+#else
+
+static inline void wake_trace_begin_wake(bool cold_boot) { (void)cold_boot; }
+static inline void wake_trace_begin(trace_phase_t phase) { (void)phase; }
+static inline void wake_trace_end(trace_phase_t phase) { (void)phase; }
+static inline void wake_trace_finish(void) {}
+static inline void wake_trace_dump_csv(FILE *f) { (void)f; }
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
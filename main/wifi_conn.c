@@ -2,31 +2,225 @@
 // File: main/wifi_conn.c
 // ==============================================
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "lwip/dhcp.h"
 #include "sdkconfig.h"
 #include "wifi_conn.h"
+#include "wake_trace.h"
 
 static const char* TAG_WIFI = "wifi_conn";
 static EventGroupHandle_t s_evt;
 static const int GOT_IP_BIT = BIT0;
+static const int LEASE_OK_BIT = BIT1;  // Verkehr über die gespeicherte Lease erfolgreich
 static bool s_initialized = false;
 static wifi_config_t s_cfg = { 0 };
 static bool s_cfg_overridden = false;
+static esp_netif_t *s_netif = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// -----------------------------------------------------------------------------
+// Schneller Reconnect: AP (BSSID/Kanal) und letzte DHCP-Lease in RTC-Memory
+// -----------------------------------------------------------------------------
+#define WIFI_FAST_MAGIC         0x57494632u  // "WIF2"
+#define WIFI_FAST_CONFIRM_MS    5000         // gespeicherte Lease ohne erfolgreiche Verbindung -> DHCP
+
+typedef struct {
+    uint32_t magic;
+    uint32_t cred_hash;         // SSID + Passwort, bei Änderung ungültig
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    bool     has_lease;
+    time_t   lease_at;
+    uint32_t lease_s;           // Wiederverwendung bis T1 laut DHCP-ACK
+    uint32_t ip;                // Netzwerk-Byteorder wie esp_ip4_addr_t
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;
+} wifi_fast_t;
+
+static RTC_DATA_ATTR wifi_fast_t s_fast;
+static bool s_fast_active = false;      // dieser Verbindungsaufbau nutzt den Cache
+static bool s_static_ip = false;        // Lease aus dem Cache statt DHCP
+static bool s_lease_dropped = false;    // gespeicherte Lease in diesem Wake verworfen
+static esp_timer_handle_t s_confirm_timer = NULL;
+
+static uint32_t wifi_cred_hash(const wifi_config_t *cfg)
+{
+    uint32_t h = 2166136261u;
+    const uint8_t *parts[2] = { cfg->sta.ssid, cfg->sta.password };
+    const size_t   lens[2]  = { sizeof(cfg->sta.ssid), sizeof(cfg->sta.password) };
+    for (int p = 0; p < 2; p++) {
+        for (size_t i = 0; i < lens[p] && parts[p][i]; i++) {
+            h ^= parts[p][i];
+            h *= 16777619u;
+        }
+        h ^= 0xFF; h *= 16777619u;  // Trenner
+    }
+    return h;
+}
+
+// Gespeicherte Lease verwerfen und DHCP starten. true, wenn die aktuelle IP
+// aus dem Cache stammte (GOT_IP kommt dann erneut, sobald DHCP fertig ist).
+static bool wifi_lease_drop(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool was_static = s_static_ip;
+    s_static_ip = false;
+    if (was_static) {
+        s_fast.has_lease = false;
+        s_lease_dropped = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (!was_static) return false;
+
+    if (s_confirm_timer) esp_timer_stop(s_confirm_timer);
+    xEventGroupClearBits(s_evt, GOT_IP_BIT);
+    wake_trace_begin(TRACE_WIFI_DHCP);
+    esp_netif_dhcpc_start(s_netif);
+    return true;
+}
+
+static bool wifi_lease_confirmed(void)
+{
+    return (xEventGroupGetBits(s_evt) & LEASE_OK_BIT) != 0;
+}
+
+static void wifi_confirm_timeout(void *arg)
+{
+    if (wifi_lease_confirmed()) return;
+    ESP_LOGW(TAG_WIFI, "Kein Verkehr über gespeicherte IP nach %d ms, DHCP", WIFI_FAST_CONFIRM_MS);
+    wifi_lease_drop();
+}
+
+// Gespeicherten AP und Lease verwerfen, normal scannen und DHCP nutzen
+static void wifi_fast_fallback(void)
+{
+    ESP_LOGW(TAG_WIFI, "Schneller Reconnect fehlgeschlagen, Scan + DHCP");
+    s_fast.magic = 0;
+    s_fast_active = false;
+
+    s_cfg.sta.bssid_set = false;
+    s_cfg.sta.channel = 0;
+    esp_wifi_set_config(WIFI_IF_STA, &s_cfg);
+
+    wifi_lease_drop();
+}
+
+// Wiederverwendbare Dauer der Lease laut letztem DHCP-ACK: bis T1, ab da
+// würde auch ein wacher Client beim Server verlängern. 0 = unbekannt.
+// struct dhcp gehört dem tcpip-Task, daher dort auslesen (esp_netif_tcpip_exec).
+static esp_err_t wifi_dhcp_lease_read(void *ctx)
+{
+    uint32_t *t1 = ctx;
+    struct netif *lwip = esp_netif_get_netif_impl(s_netif);
+    struct dhcp *dhcp = lwip ? netif_dhcp_data(lwip) : NULL;
+    if (!dhcp || !dhcp->offered_t0_lease) return ESP_ERR_NOT_FOUND;
+
+    *t1 = dhcp->offered_t1_renew;
+    if (!*t1 || *t1 > dhcp->offered_t0_lease) *t1 = dhcp->offered_t0_lease / 2;
+    return ESP_OK;
+}
+
+static uint32_t wifi_dhcp_lease_s(void)
+{
+    uint32_t t1 = 0;
+    if (esp_netif_tcpip_exec(wifi_dhcp_lease_read, &t1) != ESP_OK) return 0;
+    return t1;
+}
+
+static void wifi_fast_store(const ip_event_got_ip_t *evt)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+
+    if (s_fast.magic != WIFI_FAST_MAGIC || s_fast.cred_hash != wifi_cred_hash(&s_cfg)) {
+        memset(&s_fast, 0, sizeof(s_fast));
+    }
+    s_fast.magic = WIFI_FAST_MAGIC;
+    s_fast.cred_hash = wifi_cred_hash(&s_cfg);
+    memcpy(s_fast.bssid, ap.bssid, sizeof(s_fast.bssid));
+    s_fast.channel = ap.primary;
+
+    if (!s_static_ip) {
+        esp_netif_dns_info_t dns = { 0 };
+        esp_netif_get_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns);
+        s_fast.ip       = evt->ip_info.ip.addr;
+        s_fast.netmask  = evt->ip_info.netmask.addr;
+        s_fast.gw       = evt->ip_info.gw.addr;
+        s_fast.dns      = dns.ip.u_addr.ip4.addr;
+        s_fast.lease_at = time(NULL);
+        s_fast.lease_s  = wifi_dhcp_lease_s();
+        s_fast.has_lease = s_fast.ip != 0 && s_fast.lease_s != 0;
+    }
+}
+
+// Vor esp_wifi_start: Kanal/BSSID und ggf. statische IP aus dem Cache setzen
+static void wifi_fast_apply(void)
+{
+    if (s_fast.magic != WIFI_FAST_MAGIC || s_fast.cred_hash != wifi_cred_hash(&s_cfg) || !s_fast.channel) {
+        return;
+    }
+    s_fast_active = true;
+    s_cfg.sta.bssid_set = true;
+    memcpy(s_cfg.sta.bssid, s_fast.bssid, sizeof(s_cfg.sta.bssid));
+    s_cfg.sta.channel = s_fast.channel;
+
+    time_t now = time(NULL);
+    if (!s_fast.has_lease || now < s_fast.lease_at || (uint32_t)(now - s_fast.lease_at) >= s_fast.lease_s) {
+        ESP_LOGI(TAG_WIFI, "Verbinde direkt auf Kanal %u, Lease per DHCP", s_fast.channel);
+        return;
+    }
+
+    esp_netif_ip_info_t ip_info = {
+        .ip      = { .addr = s_fast.ip },
+        .netmask = { .addr = s_fast.netmask },
+        .gw      = { .addr = s_fast.gw },
+    };
+    esp_netif_dns_info_t dns = { .ip = { .type = ESP_IPADDR_TYPE_V4, .u_addr = { .ip4 = { .addr = s_fast.dns } } } };
+
+    esp_netif_dhcpc_stop(s_netif);
+    if (esp_netif_set_ip_info(s_netif, &ip_info) != ESP_OK) {
+        esp_netif_dhcpc_start(s_netif);
+        return;
+    }
+    if (s_fast.dns) esp_netif_set_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns);
+    s_static_ip = true;
+    xEventGroupClearBits(s_evt, LEASE_OK_BIT);
+    ESP_LOGI(TAG_WIFI, "Verbinde direkt auf Kanal %u mit gespeicherter IP " IPSTR " (noch %lu s)",
+             s_fast.channel, IP2STR(&ip_info.ip),
+             (unsigned long)(s_fast.lease_s - (uint32_t)(now - s_fast.lease_at)));
+}
 
 static void event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
 {
     if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
+    } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_CONNECTED) {
+        wake_trace_end(TRACE_WIFI_ASSOC);
+        wake_trace_begin(TRACE_WIFI_DHCP);
     } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (s_fast_active) wifi_fast_fallback();
         ESP_LOGW(TAG_WIFI, "Wi-Fi disconnected, reconnecting...");
+        wake_trace_begin(TRACE_WIFI_ASSOC);
         esp_wifi_connect();
     } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        wake_trace_end(TRACE_WIFI_DHCP);
+        wifi_fast_store((const ip_event_got_ip_t *)data);
+        s_fast_active = false;
+        // Gespeicherte Lease erst behalten, wenn tatsächlich Verkehr durchgeht
+        if (s_static_ip && !wifi_lease_confirmed() && s_confirm_timer) {
+            esp_timer_start_once(s_confirm_timer, (uint64_t)WIFI_FAST_CONFIRM_MS * 1000);
+        }
         xEventGroupSetBits(s_evt, GOT_IP_BIT);
     }
 }
@@ -36,7 +230,7 @@ void wifi_conn_init(void)
     if (s_initialized) return;
     s_evt = xEventGroupCreate();
 
-    esp_netif_create_default_wifi_sta();   // <— wichtig für DHCP/IP Events
+    s_netif = esp_netif_create_default_wifi_sta();   // <— wichtig für DHCP/IP Events
 
     wifi_init_config_t init_cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&init_cfg));
@@ -44,6 +238,9 @@ void wifi_conn_init(void)
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL, NULL));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL, NULL));
 
+    const esp_timer_create_args_t confirm_args = { .callback = wifi_confirm_timeout, .name = "wifi_lease" };
+    ESP_ERROR_CHECK(esp_timer_create(&confirm_args, &s_confirm_timer));
+
     if (!s_cfg_overridden) {
         #ifdef CONFIG_WIFI_SSID
             strlcpy((char*)s_cfg.sta.ssid, CONFIG_WIFI_SSID, sizeof(s_cfg.sta.ssid));
@@ -65,7 +262,9 @@ void wifi_conn_init(void)
 
 void wifi_conn_start(void)
 {
+    wifi_fast_apply();
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &s_cfg));
+    wake_trace_begin(TRACE_WIFI_ASSOC);
     ESP_ERROR_CHECK(esp_wifi_start());
 }
 
@@ -75,6 +274,27 @@ bool wifi_conn_wait_ip(TickType_t timeout_ticks)
     return (bits & GOT_IP_BIT) != 0;
 }
 
+void wifi_conn_traffic_ok(void)
+{
+    if (wifi_lease_confirmed()) return;
+    xEventGroupSetBits(s_evt, LEASE_OK_BIT);
+    if (s_confirm_timer) esp_timer_stop(s_confirm_timer);
+}
+
+bool wifi_conn_lease_recover(TickType_t timeout_ticks)
+{
+    // Lief über die gespeicherte Lease schon Verkehr, liegt der Fehler nicht an ihr
+    bool dropped = !wifi_lease_confirmed() && wifi_lease_drop();
+    taskENTER_CRITICAL(&s_lock);
+    dropped |= s_lease_dropped;
+    s_lease_dropped = false;
+    taskEXIT_CRITICAL(&s_lock);
+    if (!dropped) return false;
+
+    ESP_LOGW(TAG_WIFI, "Gespeicherte Lease verworfen, warte auf DHCP");
+    return wifi_conn_wait_ip(timeout_ticks);
+}
+
 void wifi_conn_set_credentials(const char *ssid, const char *password)
 {
     if (!ssid) return;
@@ -13,6 +13,17 @@ extern "C" {
 void wifi_conn_init(void);
 void wifi_conn_start(void);
 bool wifi_conn_wait_ip(TickType_t timeout_ticks);
+
+/* Erste erfolgreiche Verbindung ins Netz: eine aus dem RTC-Cache übernommene
+ * DHCP-Lease gilt damit als bestätigt. Ohne Bestätigung binnen weniger Sekunden
+ * wird sie verworfen und DHCP gestartet. */
+void wifi_conn_traffic_ok(void);
+
+/* DNS oder Verbindungsaufbau fehlgeschlagen: stammt die IP aus dem Cache (oder
+ * wurde sie deshalb schon verworfen), Lease löschen, DHCP neu starten und bis
+ * timeout_ticks auf die neue IP warten. true = neue IP, erneut versuchen. */
+bool wifi_conn_lease_recover(TickType_t timeout_ticks);
+
 void wifi_conn_set_credentials(const char *ssid, const char *password);
 
 #ifdef __cplusplus
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# Prüft nach dem Linken, wie viel RTC-Memory (ESP32-S3) belegt ist, und
+# bricht den Build ab, wenn in einem Bereich weniger als --min-free Bytes
+# frei bleiben. Der Linker meldet nur einen Überlauf; hier fällt schon auf,
+# wenn der Platz knapp wird (TLS-Session, Caches, Trace-Ring).
+#
+#   tools/check_rtc_usage.py build/esp-wartezeiten.elf [--min-free 256]
+#
+# Wird als POST_BUILD-Schritt aus der CMakeLists.txt aufgerufen.
+import argparse
+import struct
+import sys
+
+# (Name, Start, Ende) der RTC-Bereiche im Adressraum des ESP32-S3
+REGIONS = (
+    ("RTC slow", 0x50000000, 0x50002000),   # RTC_DATA_ATTR, RTC_NOINIT_ATTR (hinter ULP-Reserve)
+    ("RTC fast", 0x600FE000, 0x60100000),   # RTC_FAST_ATTR, Wake-Stub; Rest wird Heap
+)
+
+SHF_ALLOC = 0x2
+SHT_SYMTAB = 2
+STT_OBJECT = 1
+
+
+def read_sections(data):
+    """Liefert (Name, Typ, Flags, Adresse, Offset, Größe, Link, Eintragsgröße) aller Sections."""
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("kein 32-Bit-Little-Endian-ELF")
+    e_shoff, = struct.unpack_from("<I", data, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    raw = [struct.unpack_from("<IIIIIIIIII", data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+    strtab_off = raw[e_shstrndx][4]
+
+    def name_at(off, base):
+        end = data.index(b"\0", base + off)
+        return data[base + off:end].decode("ascii", "replace")
+
+    return [(name_at(s[0], strtab_off), s[1], s[2], s[3], s[4], s[5], s[6], s[9]) for s in raw]
+
+
+def read_symbols(data, sections):
+    """Liefert (Name, Adresse, Größe) aller Datenobjekte."""
+    for _, sh_type, _, _, off, size, link, entsize in sections:
+        if sh_type != SHT_SYMTAB or not entsize:
+            continue
+        str_off = sections[link][4]
+        for i in range(size // entsize):
+            st_name, st_value, st_size, st_info, _, _ = struct.unpack_from("<IIIBBH", data, off + i * entsize)
+            if st_size and (st_info & 0xF) == STT_OBJECT:
+                end = data.index(b"\0", str_off + st_name)
+                yield data[str_off + st_name:end].decode("ascii", "replace"), st_value, st_size
+
+
+def used_bytes(spans):
+    """Summe der Vereinigung aller [start, end); überlappende Sections zählen einmal."""
+    total = 0
+    cur_start = cur_end = None
+    for start, end in sorted(spans):
+        if cur_end is None or start > cur_end:
+            if cur_end is not None:
+                total += cur_end - cur_start
+            cur_start, cur_end = start, end
+        else:
+            cur_end = max(cur_end, end)
+    if cur_end is not None:
+        total += cur_end - cur_start
+    return total
+
+
+def main():
+    ap = argparse.ArgumentParser(description="RTC-Memory-Belegung eines ESP32-S3-ELF prüfen")
+    ap.add_argument("elf")
+    ap.add_argument("--min-free", type=int, default=256, help="geforderte Reserve pro Bereich in Bytes")
+    ap.add_argument("--top", type=int, default=8, help="größte Objekte pro Bereich anzeigen")
+    args = ap.parse_args()
+
+    with open(args.elf, "rb") as f:
+        data = f.read()
+    sections = read_sections(data)
+    symbols = list(read_symbols(data, sections))
+
+    ok = True
+    for region, lo, hi in REGIONS:
+        spans = [(addr, addr + size) for name, _, flags, addr, _, size, _, _ in sections
+                 if flags & SHF_ALLOC and size and lo <= addr < hi]
+        if not spans:
+            continue
+        # Der erste Abschnitt beginnt hinter reservierten Bytes (ULP, Bootloader)
+        start = min(s for s, _ in spans)
+        used = used_bytes(spans)
+        free = hi - start - used
+        print("%-8s %5d von %5d Bytes belegt, %5d frei" % (region, used, hi - start, free))
+
+        top = sorted((s for s in symbols if lo <= s[1] < hi), key=lambda s: -s[2])[:args.top]
+        for name, _, size in top:
+            print("           %5d  %s" % (size, name))
+
+        if free < args.min_free:
+            print("FEHLER: %s hat nur noch %d Bytes frei, gefordert sind %d" % (region, free, args.min_free),
+                  file=sys.stderr)
+            ok = False
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,238 @@
+// ==============================================
+// File: tools/epd_sim/epd_bench.c
+// ==============================================
+// Spielt eine Folge von Wakes gegen den emulierten SSD1681 durch: Planer
+// (epd_refresh.c), Waveform-Auswahl (epd_lut.c) und Treiber wie im
+// Print-Task, mit echtem DEV_Config.c. Pro Wake Refresh-Art, SPI-Bytes,
+// Transaktionen, Pinwechsel, BUSY- und SPI-Zeit; am Ende wird geprüft, ob
+// das sichtbare Bild jedes Mal dem gerenderten Frame entspricht.
+//
+//   make -C tools/epd_sim run
+//   tools/epd_sim/epd_bench -n 40 -t 8 -b -o /tmp/epd
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DEV_Config.h"
+#include "EPD_1in54_V2.h"
+#include "epd_lut.h"
+#include "epd_refresh.h"
+#include "esp_log.h"
+#include "host_idf.h"
+#include "ssd1681_sim.h"
+
+#define MAX_WINDOWS     4       // wie EPD_DIRTY_WINDOWS im Print-Task
+#define DIGIT_W         40
+#define DIGIT_H         80
+#define SEG             10
+
+// Wartezeiten im Minutentakt; Wiederholungen ergeben Wakes ohne Refresh
+static const int s_wait_min[] = { 5, 5, 10, 10, 15, 20, 20, 25, 30, 30, 35, 40, 45, 45, 40, 35, 30, 25, 20, 15 };
+
+typedef struct {
+    int      wakes;
+    int      interval_min;
+    float    temp_c;
+    bool     defer;
+    const char *out_dir;
+} bench_opts_t;
+
+static void px_black(uint8_t *fb, int x, int y)
+{
+    fb[y * SSD1681_STRIDE + x / 8] &= (uint8_t)~(0x80 >> (x & 7));
+}
+
+static void rect(uint8_t *fb, int x, int y, int w, int h)
+{
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) px_black(fb, i, j);
+    }
+}
+
+// Sieben-Segment-Ziffer statt Roboto, reicht für realistische Änderungsflächen
+static void digit(uint8_t *fb, int x, int y, int d)
+{
+    static const uint8_t seg[10] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F };
+    uint8_t m = seg[d % 10];
+    int h2 = DIGIT_H / 2;
+    if (m & 0x01) rect(fb, x, y, DIGIT_W, SEG);                              // a
+    if (m & 0x02) rect(fb, x + DIGIT_W - SEG, y, SEG, h2);                   // b
+    if (m & 0x04) rect(fb, x + DIGIT_W - SEG, y + h2, SEG, h2);              // c
+    if (m & 0x08) rect(fb, x, y + DIGIT_H - SEG, DIGIT_W, SEG);              // d
+    if (m & 0x10) rect(fb, x, y + h2, SEG, h2);                              // e
+    if (m & 0x20) rect(fb, x, y, SEG, h2);                                   // f
+    if (m & 0x40) rect(fb, x, y + h2 - SEG / 2, DIGIT_W, SEG);               // g
+}
+
+static void render(uint8_t *fb, int wait_min)
+{
+    memset(fb, 0xFF, SSD1681_FRAME_BYTES);
+    // Logos oben und unten: feste Muster, ändern sich nie
+    for (int y = 0; y < 36; y++) {
+        for (int x = 20; x < 180; x++) if (((x / 4) + (y / 4)) & 1) px_black(fb, x, y);
+    }
+    for (int y = 176; y < 200; y++) {
+        for (int x = 60; x < 140; x++) if ((x ^ y) & 2) px_black(fb, x, y);
+    }
+    digit(fb, 52, 62, wait_min / 10);
+    digit(fb, 108, 62, wait_min % 10);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "%s [-n Wakes] [-i Minuten] [-t °C] [-b] [-o Verzeichnis] [-v]\n"
+            "  -b  Refresh blockierend statt im Deep Sleep (CONFIG_EPD_REFRESH_IN_DEEP_SLEEP=n)\n"
+            "  -o  sichtbares Bild nach jedem Refresh als PBM ablegen\n", prog);
+}
+
+static bool parse(int argc, char **argv, bench_opts_t *o)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:i:t:bo:vh")) != -1) {
+        switch (c) {
+        case 'n': o->wakes = atoi(optarg); break;
+        case 'i': o->interval_min = atoi(optarg); break;
+        case 't': o->temp_c = strtof(optarg, NULL); break;
+        case 'b': o->defer = false; break;
+        case 'o': o->out_dir = optarg; break;
+        case 'v': host_log_level = 2; break;
+        default:  usage(argv[0]); return false;
+        }
+    }
+    return o->wakes > 0 && o->interval_min > 0;
+}
+
+// Im letzten Wake übertragene Fenster; im Print-Task liegen sie im RTC-Memory
+static EPD_1IN54_V2_Window s_sync_win[MAX_WINDOWS];
+static uint8_t s_sync_count;
+
+// display_resume: der im letzten Wake gestartete Waveform ist durch, nur die
+// damals geänderten Fenster ins Vergleichsbild nachziehen
+static void resume_panel(void)
+{
+    DEV_Module_Init();
+    EPD_1IN54_V2_WaitIdle();
+    const uint8_t *last = epd_refresh_last_frame();
+    if (last && s_sync_count) EPD_1IN54_V2_SyncOldRamWindows(last, s_sync_win, s_sync_count);
+    s_sync_count = 0;
+    EPD_1IN54_V2_Sleep();
+    epd_refresh_set_panel_retained(last != NULL);
+}
+
+// panel_output + Sleep-Hook des Print-Tasks; Anzahl der Fenster oder -1
+static int output(epd_refresh_t mode, const uint8_t *frame, time_t now, bool defer)
+{
+    int windows = -1;
+    DEV_Module_Init();
+    epd_lut_select(now);
+    EPD_1IN54_V2_DeferActivation(defer ? 1 : 0);
+
+    EPD_1IN54_V2_Window win[MAX_WINDOWS];
+    uint8_t count = 0;
+    if (mode == EPD_REFRESH_PARTIAL) {
+        count = (uint8_t)epd_refresh_dirty_windows(frame, win, MAX_WINDOWS);
+    }
+    if (mode == EPD_REFRESH_PARTIAL && epd_refresh_panel_ram_valid()) {
+        windows = count;
+        EPD_1IN54_V2_Init_Partial();
+        EPD_1IN54_V2_DisplayPartWindows(frame, win, count);
+    } else if (mode == EPD_REFRESH_PARTIAL) {
+        EPD_1IN54_V2_Init_Partial();
+        EPD_1IN54_V2_DisplayPartDiff(epd_refresh_last_frame(), frame);
+    } else {
+        EPD_1IN54_V2_Init();
+        EPD_1IN54_V2_DisplayPartBaseImage((UBYTE *)frame);
+    }
+    epd_refresh_commit(frame, mode, now);
+
+    if (!EPD_1IN54_V2_ActivatePending()) {
+        EPD_1IN54_V2_Sleep();
+    } else {
+        s_sync_count = count;
+        memcpy(s_sync_win, win, sizeof(s_sync_win));
+    }
+    epd_refresh_set_panel_retained(true);
+    return windows;
+}
+
+int main(int argc, char **argv)
+{
+    bench_opts_t o = { .wakes = 30, .interval_min = 1, .temp_c = 22.0f, .defer = true };
+    if (!parse(argc, argv, &o)) return 2;
+
+    ssd1681_sim_power_on(0x1681);
+    ssd1681_sim_set_temperature(o.temp_c);
+
+    static uint8_t frame[SSD1681_FRAME_BYTES];
+    time_t now = 1760000000;
+    bool pending = false;
+    uint32_t bad_wakes = 0;
+    ssd1681_stats_t total0;
+    ssd1681_sim_get_stats(&total0);
+
+    printf("wake mode        band    win  bytes  spi_tx  cs  dc  rst  busy_ms  spi_ms  wake_ms  falsch_px\n");
+    for (int k = 0; k < o.wakes; k++, now += (time_t)o.interval_min * 60) {
+        ssd1681_stats_t a, b;
+        host_spi_stats_t sa, sb;
+        ssd1681_sim_get_stats(&a);
+        host_spi_get_stats(&sa);
+        uint64_t t0 = ssd1681_sim_now_us();
+
+        if (pending) {
+            resume_panel();
+            pending = false;
+        }
+
+        render(frame, s_wait_min[k % (int)(sizeof(s_wait_min) / sizeof(s_wait_min[0]))]);
+        epd_refresh_t mode = epd_refresh_plan(frame, now);
+        int windows = -1;
+        epd_lut_band_t band = EPD_LUT_COUNT;
+        if (mode != EPD_REFRESH_NONE) {
+            windows = output(mode, frame, now, o.defer);
+            band = epd_lut_select(now);     // aus dem Cache, misst nicht erneut
+            pending = o.defer;
+        }
+
+        ssd1681_sim_get_stats(&b);
+        host_spi_get_stats(&sb);
+        uint32_t wrong = ssd1681_sim_diff(ssd1681_sim_visible(), frame);
+        if (wrong || b.errors != a.errors) bad_wakes++;
+
+        printf("%4d %-11s %-7s %3d %6u %7u %3u %3u %4u %8.1f %7.2f %8.1f %10u%s\n",
+               k, epd_refresh_to_string(mode), band < EPD_LUT_COUNT ? epd_lut_to_string(band) : "-",
+               windows, b.bytes - a.bytes, sb.transactions - sa.transactions,
+               b.transactions - a.transactions,
+               b.pin_toggles[SSD1681_PIN_DC] - a.pin_toggles[SSD1681_PIN_DC],
+               b.pin_toggles[SSD1681_PIN_RST] - a.pin_toggles[SSD1681_PIN_RST],
+               (b.busy_us - a.busy_us) / 1000.0, (b.spi_us - a.spi_us) / 1000.0,
+               (ssd1681_sim_now_us() - t0) / 1000.0, wrong,
+               b.errors != a.errors ? "  [Kommando bei BUSY/Sleep]" : "");
+
+        if (o.out_dir && mode != EPD_REFRESH_NONE) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/wake_%03d.pbm", o.out_dir, k);
+            if (!ssd1681_sim_write_pbm(path, ssd1681_sim_visible())) {
+                fprintf(stderr, "%s: konnte nicht geschrieben werden\n", path);
+            }
+        }
+
+        // Deep Sleep bis zum nächsten Wake; ein laufender Waveform endet darin
+        ssd1681_sim_advance_us((uint64_t)o.interval_min * 60u * 1000000u);
+    }
+
+    ssd1681_stats_t t;
+    ssd1681_sim_get_stats(&t);
+    printf("\nSumme: %u Voll-, %u Teilrefreshs, %u Bytes, %u CS-Zyklen, BUSY %.1f ms, SPI %.1f ms, %u Fehler\n",
+           t.refresh_full - total0.refresh_full, t.refresh_partial - total0.refresh_partial,
+           t.bytes - total0.bytes, t.transactions - total0.transactions,
+           (t.busy_us - total0.busy_us) / 1000.0, (t.spi_us - total0.spi_us) / 1000.0,
+           t.errors - total0.errors);
+    if (bad_wakes) {
+        printf("%u Wakes mit falschem Bild oder unzulässigem Kommando\n", bad_wakes);
+        return 1;
+    }
+    return 0;
+}
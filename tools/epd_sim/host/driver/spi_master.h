@@ -0,0 +1,43 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+typedef enum { SPI1_HOST = 0, SPI2_HOST, SPI3_HOST } spi_host_device_t;
+#define SPI_DMA_CH_AUTO             3
+#define SPI_DEVICE_HALFDUPLEX       (1u << 4)
+#define SPI_DEVICE_3WIRE            (1u << 2)
+#define SPI_TRANS_USE_RXDATA        (1u << 2)
+#define SPI_TRANS_USE_TXDATA        (1u << 3)
+#define SPI_TRANS_CS_KEEP_ACTIVE    (1u << 8)
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t *t);
+struct spi_transaction_t {
+    uint32_t flags;
+    size_t length;
+    size_t rxlength;
+    void *user;
+    union { const void *tx_buffer; uint8_t tx_data[4]; };
+    union { void *rx_buffer; uint8_t rx_data[4]; };
+};
+typedef struct {
+    int mosi_io_num, miso_io_num, sclk_io_num, quadwp_io_num, quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+typedef struct {
+    uint8_t mode;
+    int clock_speed_hz;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+} spi_device_interface_config_t;
+typedef struct spi_device_t *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *cfg, int dma);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg, spi_device_handle_t *out);
+esp_err_t spi_bus_remove_device(spi_device_handle_t dev);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t dev, spi_transaction_t *t);
+esp_err_t spi_device_transmit(spi_device_handle_t dev, spi_transaction_t *t);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t dev, uint32_t wait);
+void spi_device_release_bus(spi_device_handle_t dev);
@@ -0,0 +1,5 @@
+#pragma once
+#define IRAM_ATTR
+#define DMA_ATTR
+#define RTC_DATA_ATTR
+#define RTC_FAST_ATTR
@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+/* Virtuelle Zeit des Emulators */
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define portMAX_DELAY           0xffffffffu
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(x)   ((void)(x))
@@ -0,0 +1,8 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+typedef void *TaskHandle_t;
+/* Einziger "Task" ist das Bench-Programm; Warten = virtuelle Zeit vorstellen */
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
@@ -0,0 +1,13 @@
+/* Host-Build des Display-Pfads: Werte wie in main/Kconfig.projbuild, ohne
+ * Wake-Trace und ohne Light Sleep während BUSY. */
+#pragma once
+#ifndef CONFIG_EPD_PARTIAL_MAX
+#define CONFIG_EPD_PARTIAL_MAX          10
+#endif
+#ifndef CONFIG_EPD_FULL_REFRESH_MIN
+#define CONFIG_EPD_FULL_REFRESH_MIN     360
+#endif
+#ifndef CONFIG_EPD_TEMP_CHECK_MIN
+#define CONFIG_EPD_TEMP_CHECK_MIN       60
+#endif
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 160
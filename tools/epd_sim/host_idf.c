@@ -0,0 +1,274 @@
+// ==============================================
+// File: tools/epd_sim/host_idf.c
+// ==============================================
+// ESP-IDF-Ersatz für den Host-Build: GPIO und SPI des Panels gehen an den
+// emulierten SSD1681, Zeit und Warten laufen auf dessen virtueller Uhr.
+#include <stdlib.h>
+#include <string.h>
+
+#include "DEV_Config.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "wake_arena.h"
+
+#include "host_idf.h"
+#include "ssd1681_sim.h"
+
+// Richtwerte ESP32-S3: Aufsetzen einer Transaktion ohne bzw. mit Interrupt/DMA
+#define SPI_POLL_OVERHEAD_US    8
+#define SPI_QUEUE_OVERHEAD_US   25
+
+int host_log_level = 0;
+
+struct spi_device_t {
+    int      clock_hz;
+    uint32_t flags;
+    transaction_cb_t pre_cb;
+};
+
+static struct spi_device_t s_dev;
+static bool s_dev_used;
+static bool s_cs_active;        // CS_KEEP_ACTIVE der letzten Transaktion
+static host_spi_stats_t s_spi;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                return "ESP_OK";
+    case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    default:                    return "ESP_FAIL";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)ssd1681_sim_now_us();
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void)
+{
+    return ESP_OK;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* ---------- FreeRTOS ---------- */
+
+void vTaskDelay(TickType_t ticks)
+{
+    ssd1681_sim_advance_us((uint64_t)ticks * 1000u);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)&s_dev;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    (void)clear;
+    vTaskDelay(ticks);
+    return 0;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    (void)task;
+    (void)woken;
+}
+
+/* ---------- GPIO ---------- */
+
+static int sim_pin(gpio_num_t pin)
+{
+    switch (pin) {
+    case EPD_RST_PIN: return SSD1681_PIN_RST;
+    case EPD_CS_PIN:  return SSD1681_PIN_CS;
+    case EPD_DC_PIN:  return SSD1681_PIN_DC;
+    default:          return -1;
+    }
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    return cfg ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    int p = sim_pin(pin);
+    if (p >= 0) {
+        ssd1681_sim_pin((ssd1681_pin_t)p, (int)level);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    return pin == EPD_BUSY_PIN ? ssd1681_sim_busy() : 0;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode)
+{
+    (void)pin;
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int flags)
+{
+    (void)flags;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type)
+{
+    (void)pin;
+    (void)type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t pin)
+{
+    (void)pin;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t pin)
+{
+    (void)pin;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t fn, void *arg)
+{
+    (void)pin;
+    (void)fn;
+    (void)arg;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type)
+{
+    (void)pin;
+    (void)type;
+    return ESP_OK;
+}
+
+/* ---------- SPI ---------- */
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *cfg, int dma)
+{
+    (void)host;
+    (void)dma;
+    return cfg ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg, spi_device_handle_t *out)
+{
+    (void)host;
+    if (!cfg || !out) return ESP_ERR_INVALID_ARG;
+    if (s_dev_used) return ESP_ERR_INVALID_STATE;
+    s_dev.clock_hz = cfg->clock_speed_hz;
+    s_dev.flags = cfg->flags;
+    s_dev.pre_cb = cfg->pre_cb;
+    s_dev_used = true;
+    *out = &s_dev;
+    s_spi.device_adds++;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t dev)
+{
+    if (dev != &s_dev || !s_dev_used) return ESP_ERR_INVALID_STATE;
+    s_dev_used = false;
+    return ESP_OK;
+}
+
+static esp_err_t transmit(spi_device_handle_t dev, spi_transaction_t *t, bool queued)
+{
+    if (dev != &s_dev || !s_dev_used || !t) return ESP_ERR_INVALID_ARG;
+    if (t->rxlength && !(dev->flags & SPI_DEVICE_3WIRE)) return ESP_ERR_INVALID_ARG;
+
+    if (dev->pre_cb) dev->pre_cb(t);
+    if (!s_cs_active) ssd1681_sim_pin(SSD1681_PIN_CS, 0);
+
+    size_t tx = t->length / 8;
+    const uint8_t *src = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : (const uint8_t *)t->tx_buffer;
+    for (size_t i = 0; i < tx && src; i++) {
+        ssd1681_sim_write(src[i]);
+    }
+    size_t rx = t->rxlength / 8;
+    uint8_t *dst = (t->flags & SPI_TRANS_USE_RXDATA) ? t->rx_data : (uint8_t *)t->rx_buffer;
+    for (size_t i = 0; i < rx && dst; i++) {
+        dst[i] = ssd1681_sim_read();
+    }
+
+    uint64_t bits = (uint64_t)(tx + rx) * 8u;
+    ssd1681_sim_spi_time((queued ? SPI_QUEUE_OVERHEAD_US : SPI_POLL_OVERHEAD_US) +
+                         bits * 1000000u / (uint64_t)dev->clock_hz);
+
+    s_cs_active = t->flags & SPI_TRANS_CS_KEEP_ACTIVE;
+    if (!s_cs_active) ssd1681_sim_pin(SSD1681_PIN_CS, 1);
+
+    s_spi.transactions++;
+    if (queued) s_spi.queued++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t dev, spi_transaction_t *t)
+{
+    return transmit(dev, t, false);
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t dev, spi_transaction_t *t)
+{
+    return transmit(dev, t, true);
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t dev, uint32_t wait)
+{
+    (void)wait;
+    return dev == &s_dev ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void spi_device_release_bus(spi_device_handle_t dev)
+{
+    // Ein offen gelassenes CS endet spätestens mit der Freigabe des Busses
+    if (dev == &s_dev && s_cs_active) {
+        s_cs_active = false;
+        ssd1681_sim_pin(SSD1681_PIN_CS, 1);
+    }
+}
+
+void host_spi_get_stats(host_spi_stats_t *stats)
+{
+    if (stats) *stats = s_spi;
+}
+
+/* ---------- Wake-Arena: auf dem Host einfach der Heap ---------- */
+
+void *wake_arena_alloc(wake_arena_id_t arena, size_t size)
+{
+    (void)arena;
+    return malloc(size);
+}
+
+void wake_arena_free(void *ptr)
+{
+    free(ptr);
+}
@@ -0,0 +1,21 @@
+// ==============================================
+// File: tools/epd_sim/host_idf.h
+// ==============================================
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t transactions;      // spi_device_*transmit-Aufrufe
+    uint32_t queued;            // davon über Interrupt/DMA
+    uint32_t device_adds;       // spi_bus_add_device (Lesezugriffe tauschen das Device)
+} host_spi_stats_t;
+
+void host_spi_get_stats(host_spi_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,364 @@
+// ==============================================
+// File: tools/epd_sim/ssd1681_sim.c
+// ==============================================
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ssd1681_sim.h"
+
+#define LUT_BYTES           159
+#define LUT_GROUPS          12
+#define LUT_TIMING          60      // 7 Bytes je Gruppe: TPA TPB SRAB TPC TPD SRCD RP
+#define LUT_FRAME_RATE      144     // 6 Bytes, je ein Nibble pro Gruppe
+
+// Richtwerte für die Abschnitte einer Update-Sequenz (0x22-Bits)
+#define T_CLOCK_US          1000
+#define T_ANALOG_ON_US      10000
+#define T_ANALOG_OFF_US     5000
+#define T_LOAD_TEMP_US      5000
+#define T_LOAD_LUT_US       3000
+#define T_SWRESET_US        2000
+#define T_OTP_FULL_US       2000000 // Waveform aus dem OTP, Modus 1
+#define T_OTP_PART_US       600000  // Waveform aus dem OTP, Modus 2
+
+static struct {
+    uint8_t  ram[2][SSD1681_H][SSD1681_STRIDE];
+    uint8_t  visible[SSD1681_FRAME_BYTES];
+    int      pins[SSD1681_PIN_COUNT];
+    bool     sleeping;
+    uint64_t now_us;
+    uint64_t busy_until_us;
+
+    uint8_t  cmd;
+    uint32_t idx;               // Parameter-/Datenbyte seit dem Kommando
+    uint8_t  p[4];
+
+    uint8_t  scan;              // 0x01 Byte 3, Bit 0 = TB
+    uint8_t  entry;             // 0x11
+    uint8_t  xs, xe, xc;        // in Bytes
+    uint16_t ys, ye, yc;
+    uint8_t  lut[LUT_BYTES];
+    bool     lut_custom;        // 0x32 geschrieben, seit Reset kein OTP-Load
+    uint8_t  update_ctrl;       // 0x22
+    uint8_t  temp_sel;          // 0x18
+    uint16_t temp_reg;          // 12 Bit, 1/16 °C
+    float    temp_c;
+
+    ssd1681_stats_t stats;
+} s = { .pins = { 1, 1, 1 }, .temp_c = 22.0f };
+
+static void reset_registers(void)
+{
+    s.scan = 0;
+    s.entry = 0x03;
+    s.xs = 0;
+    s.xe = SSD1681_STRIDE - 1;
+    s.ys = 0;
+    s.ye = SSD1681_H - 1;
+    s.xc = 0;
+    s.yc = 0;
+    s.lut_custom = false;
+    s.update_ctrl = 0xFF;
+    s.temp_sel = 0x48;
+    s.cmd = 0;
+    s.idx = 0;
+}
+
+void ssd1681_sim_power_on(uint32_t seed)
+{
+    uint32_t x = seed ? seed : 1;
+    uint8_t *ram = &s.ram[0][0][0];
+    for (size_t i = 0; i < sizeof(s.ram); i++) {
+        x = x * 1664525u + 1013904223u;
+        ram[i] = (uint8_t)(x >> 24);
+    }
+    for (size_t i = 0; i < sizeof(s.visible); i++) {
+        x = x * 1664525u + 1013904223u;
+        s.visible[i] = (uint8_t)(x >> 24);
+    }
+    reset_registers();
+    s.sleeping = false;
+    s.busy_until_us = s.now_us;
+}
+
+void ssd1681_sim_set_temperature(float celsius)
+{
+    s.temp_c = celsius;
+}
+
+static int frame_rate_hz(int group)
+{
+    uint8_t b = s.lut[LUT_FRAME_RATE + group / 2];
+    int code = (group & 1) ? (b & 0x0F) : (b >> 4);
+    return code ? 25 * code : 25;
+}
+
+// Dauer des Waveforms aus dem geladenen LUT
+static uint64_t waveform_us(bool mode2)
+{
+    if (!s.lut_custom) {
+        return mode2 ? T_OTP_PART_US : T_OTP_FULL_US;
+    }
+    uint64_t us = 0;
+    for (int g = 0; g < LUT_GROUPS; g++) {
+        const uint8_t *t = &s.lut[LUT_TIMING + 7 * g];
+        uint32_t frames = ((t[0] + t[1]) * (t[2] + 1u) + (t[3] + t[4]) * (t[5] + 1u)) * (t[6] + 1u);
+        us += (uint64_t)frames * 1000000u / (uint64_t)frame_rate_hz(g);
+    }
+    return us;
+}
+
+void ssd1681_sim_ram_image(int bank, uint8_t *out)
+{
+    bool tb = s.scan & 0x01;
+    for (int r = 0; r < SSD1681_H; r++) {
+        int y = tb ? SSD1681_H - 1 - r : r;
+        memcpy(out + r * SSD1681_STRIDE, s.ram[bank & 1][y], SSD1681_STRIDE);
+    }
+}
+
+static void display(bool mode2)
+{
+    uint8_t cur[SSD1681_FRAME_BYTES], old[SSD1681_FRAME_BYTES];
+    ssd1681_sim_ram_image(0, cur);
+    ssd1681_sim_ram_image(1, old);
+    for (int i = 0; i < SSD1681_FRAME_BYTES; i++) {
+        // Modus 2 treibt nur Pixel, deren alter und neuer RAM-Wert verschieden sind
+        uint8_t drive = mode2 ? (uint8_t)(cur[i] ^ old[i]) : 0xFF;
+        s.visible[i] = (uint8_t)((s.visible[i] & ~drive) | (cur[i] & drive));
+    }
+    if (mode2) {
+        s.stats.refresh_partial++;
+    } else {
+        s.stats.refresh_full++;
+    }
+}
+
+static void activate(void)
+{
+    uint8_t m = s.update_ctrl;
+    uint64_t us = 0;
+    if (m & 0x80) us += T_CLOCK_US;
+    if (m & 0x40) us += T_ANALOG_ON_US;
+    if (m & 0x20) {
+        if (s.temp_sel == 0x80) {
+            s.temp_reg = (uint16_t)lroundf(s.temp_c * 16.0f) & 0x0FFF;
+        }
+        us += T_LOAD_TEMP_US;
+    }
+    if (m & 0x10) {
+        s.lut_custom = false;
+        us += T_LOAD_LUT_US;
+    }
+    if (m & 0x04) {
+        bool mode2 = m & 0x08;
+        us += waveform_us(mode2);
+        display(mode2);
+    }
+    if (m & 0x02) us += T_ANALOG_OFF_US;
+
+    s.busy_until_us = s.now_us + us;
+    s.stats.busy_us += us;
+}
+
+static bool step(uint16_t *c, uint16_t a, uint16_t b, bool inc)
+{
+    uint16_t lo = a < b ? a : b;
+    uint16_t hi = a < b ? b : a;
+    if (inc) {
+        if (*c >= hi) { *c = lo; return true; }
+        (*c)++;
+    } else {
+        if (*c <= lo) { *c = hi; return true; }
+        (*c)--;
+    }
+    return false;
+}
+
+static void ram_write(int bank, uint8_t b)
+{
+    if (s.xc >= SSD1681_STRIDE || s.yc >= SSD1681_H) {
+        s.stats.errors++;
+    } else {
+        s.ram[bank][s.yc][s.xc] = b;
+    }
+
+    uint16_t xc = s.xc;
+    bool xinc = s.entry & 0x01, yinc = s.entry & 0x02;
+    if (!(s.entry & 0x04)) {
+        if (step(&xc, s.xs, s.xe, xinc)) step(&s.yc, s.ys, s.ye, yinc);
+    } else {
+        if (step(&s.yc, s.ys, s.ye, yinc)) step(&xc, s.xs, s.xe, xinc);
+    }
+    s.xc = (uint8_t)xc;
+}
+
+static void command(uint8_t c)
+{
+    s.cmd = c;
+    s.idx = 0;
+    s.stats.commands++;
+    switch (c) {
+    case 0x12:
+        reset_registers();
+        s.busy_until_us = s.now_us + T_SWRESET_US;
+        s.stats.busy_us += T_SWRESET_US;
+        break;
+    case 0x20:
+        activate();
+        break;
+    default:
+        break;
+    }
+}
+
+static void data(uint8_t b)
+{
+    uint32_t i = s.idx++;
+    if (i < sizeof(s.p)) s.p[i] = b;
+
+    switch (s.cmd) {
+    case 0x01: if (i == 2) s.scan = b; break;
+    case 0x10: if (i == 0) s.sleeping = (b & 0x03) != 0; break;
+    case 0x11: if (i == 0) s.entry = b & 0x07; break;
+    case 0x18: if (i == 0) s.temp_sel = b; break;
+    case 0x1A: if (i == 1) s.temp_reg = (uint16_t)(((s.p[0] << 4) | (b >> 4)) & 0x0FFF); break;
+    case 0x22: if (i == 0) s.update_ctrl = b; break;
+    case 0x24: ram_write(0, b); break;
+    case 0x26: ram_write(1, b); break;
+    case 0x32:
+        if (i < 153) s.lut[i] = b;
+        if (i == 152) s.lut_custom = true;
+        break;
+    case 0x3F: if (i == 0) s.lut[153] = b; break;
+    case 0x03: if (i == 0) s.lut[154] = b; break;
+    case 0x04: if (i < 3) s.lut[155 + i] = b; break;
+    case 0x2C: if (i == 0) s.lut[158] = b; break;
+    case 0x44:
+        if (i == 0) s.xs = b & 0x3F;
+        if (i == 1) s.xe = b & 0x3F;
+        break;
+    case 0x45:
+        if (i == 1) s.ys = (uint16_t)(s.p[0] | ((b & 0x01) << 8));
+        if (i == 3) s.ye = (uint16_t)(s.p[2] | ((b & 0x01) << 8));
+        break;
+    case 0x4E: if (i == 0) s.xc = b & 0x3F; break;
+    case 0x4F: if (i == 1) s.yc = (uint16_t)(s.p[0] | ((b & 0x01) << 8)); break;
+    default: break;     // 0x3C, 0x37, ...: für das Bild ohne Bedeutung
+    }
+}
+
+void ssd1681_sim_pin(ssd1681_pin_t pin, int level)
+{
+    if (pin >= SSD1681_PIN_COUNT) return;
+    level = level ? 1 : 0;
+    int prev = s.pins[pin];
+    if (prev == level) return;
+    s.pins[pin] = level;
+    s.stats.pin_toggles[pin]++;
+
+    if (pin == SSD1681_PIN_RST && level) {
+        // Hardware-Reset weckt aus dem Deep Sleep, RAM bleibt erhalten
+        reset_registers();
+        s.sleeping = false;
+        s.busy_until_us = s.now_us;
+    } else if (pin == SSD1681_PIN_CS && level) {
+        s.stats.transactions++;
+    }
+}
+
+bool ssd1681_sim_busy(void)
+{
+    return s.now_us < s.busy_until_us;
+}
+
+void ssd1681_sim_write(uint8_t byte)
+{
+    s.stats.bytes++;
+    if (s.pins[SSD1681_PIN_CS] || !s.pins[SSD1681_PIN_RST] || s.sleeping) {
+        s.stats.errors++;
+        return;
+    }
+    // Laut Datenblatt verboten; das Panel übernimmt Register meist trotzdem
+    if (ssd1681_sim_busy()) {
+        s.stats.errors++;
+    }
+    if (s.pins[SSD1681_PIN_DC]) {
+        data(byte);
+    } else {
+        command(byte);
+    }
+}
+
+uint8_t ssd1681_sim_read(void)
+{
+    s.stats.bytes++;
+    if (s.pins[SSD1681_PIN_CS] || s.sleeping) {
+        s.stats.errors++;
+        return 0xFF;
+    }
+    uint32_t i = s.idx++;
+    if (s.cmd == 0x1B) {
+        if (i == 0) return (uint8_t)(s.temp_reg >> 4);
+        if (i == 1) return (uint8_t)((s.temp_reg & 0x0F) << 4);
+    }
+    return 0xFF;
+}
+
+uint64_t ssd1681_sim_now_us(void)
+{
+    return s.now_us;
+}
+
+void ssd1681_sim_advance_us(uint64_t us)
+{
+    s.now_us += us;
+}
+
+void ssd1681_sim_spi_time(uint64_t us)
+{
+    s.now_us += us;
+    s.stats.spi_us += us;
+}
+
+bool ssd1681_sim_sleeping(void)
+{
+    return s.sleeping;
+}
+
+bool ssd1681_sim_custom_lut(void)
+{
+    return s.lut_custom;
+}
+
+const uint8_t *ssd1681_sim_visible(void)
+{
+    return s.visible;
+}
+
+uint32_t ssd1681_sim_diff(const uint8_t *a, const uint8_t *b)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < SSD1681_FRAME_BYTES; i++) {
+        n += (uint32_t)__builtin_popcount((unsigned)(a[i] ^ b[i]));
+    }
+    return n;
+}
+
+bool ssd1681_sim_write_pbm(const char *path, const uint8_t *image)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P4\n%d %d\n", SSD1681_W, SSD1681_H);
+    // PBM: 1 = schwarz, Panel-RAM: 1 = weiß
+    for (int i = 0; i < SSD1681_FRAME_BYTES; i++) {
+        fputc((uint8_t)~image[i], f);
+    }
+    return fclose(f) == 0;
+}
+
+void ssd1681_sim_get_stats(ssd1681_stats_t *stats)
+{
+    if (stats) *stats = s.stats;
+}
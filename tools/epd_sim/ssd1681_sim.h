@@ -0,0 +1,78 @@
+// ==============================================
+// File: tools/epd_sim/ssd1681_sim.h
+// ==============================================
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Emulierter SSD1681 (200x200, 1 bpp) für den Host-Build von DEV_Config.c
+ * und EPD_1in54_V2.c. Dekodiert die Kommandos, die der Treiber benutzt,
+ * hält beide RAM-Bänke, modelliert BUSY aus dem geladenen LUT und zählt
+ * Transaktionen, Bytes und Pinwechsel. Die Zeit ist virtuell: Wartezeiten
+ * des Treibers und SPI-Transfers schieben sie vor.
+ *
+ * Sichtbares Bild: Vollrefresh (Modus 1) übernimmt RAM 0x24 komplett,
+ * Teilrefresh (Modus 2) nur Pixel, die sich zwischen 0x26 und 0x24
+ * unterscheiden. Ein veraltetes 0x26 fällt so als falsches Bild auf.
+ */
+
+#define SSD1681_W           200
+#define SSD1681_H           200
+#define SSD1681_STRIDE      (SSD1681_W / 8)
+#define SSD1681_FRAME_BYTES (SSD1681_STRIDE * SSD1681_H)
+
+typedef enum {
+    SSD1681_PIN_RST = 0,
+    SSD1681_PIN_CS,
+    SSD1681_PIN_DC,
+    SSD1681_PIN_COUNT
+} ssd1681_pin_t;
+
+typedef struct {
+    uint32_t transactions;      // CS low -> high
+    uint32_t bytes;             // Kommando- und Datenbytes
+    uint32_t commands;
+    uint32_t pin_toggles[SSD1681_PIN_COUNT];
+    uint32_t refresh_full;
+    uint32_t refresh_partial;
+    uint64_t busy_us;           // Summe aller BUSY-high-Phasen
+    uint64_t spi_us;            // Zeit mit CS low
+    uint32_t errors;            // Kommandos bei BUSY, im Deep Sleep, außerhalb des RAMs
+} ssd1681_stats_t;
+
+/* Kaltstart: Register auf Reset-Werte, RAM mit Zufallsmuster, Zeit und Zähler bleiben. */
+void ssd1681_sim_power_on(uint32_t seed);
+
+void ssd1681_sim_set_temperature(float celsius);
+
+void ssd1681_sim_pin(ssd1681_pin_t pin, int level);
+bool ssd1681_sim_busy(void);
+void ssd1681_sim_write(uint8_t byte);           // mit aktuellem DC, CS muss low sein
+uint8_t ssd1681_sim_read(void);
+
+uint64_t ssd1681_sim_now_us(void);
+void ssd1681_sim_advance_us(uint64_t us);
+void ssd1681_sim_spi_time(uint64_t us);         // Transferzeit, zählt zu spi_us
+
+bool ssd1681_sim_sleeping(void);
+bool ssd1681_sim_custom_lut(void);
+
+/* Bilder im Framebuffer-Layout des Print-Tasks (Zeile 0 oben, MSB links, 1 = weiß). */
+const uint8_t *ssd1681_sim_visible(void);
+void ssd1681_sim_ram_image(int bank, uint8_t *out);    // 0 = 0x24, 1 = 0x26
+
+/* Pixel, die sich zwischen a und b unterscheiden. */
+uint32_t ssd1681_sim_diff(const uint8_t *a, const uint8_t *b);
+
+bool ssd1681_sim_write_pbm(const char *path, const uint8_t *image);
+
+void ssd1681_sim_get_stats(ssd1681_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
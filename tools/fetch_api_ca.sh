@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# Holt die ausstellende CA-Kette (ohne Leaf-Zertifikat) des API-Hosts und
+# schreibt sie nach main/certs/api_ca.pem (für CONFIG_API_TLS_PINNED_CA).
+# Gespeichert wird nur, wenn sich die Kette samt Hostname gegen den
+# CA-Store des Systems verifizieren lässt.
+#
+#   tools/fetch_api_ca.sh [host] [port]
+#   API_CA_OUT=<datei> überschreibt das Ziel.
+set -euo pipefail
+
+HOST="${1:-api.wartezeiten.app}"
+PORT="${2:-443}"
+OUT="${API_CA_OUT:-$(dirname "$0")/../main/certs/api_ca.pem}"
+
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+
+openssl s_client -connect "${HOST}:${PORT}" -servername "${HOST}" -showcerts </dev/null 2>/dev/null \
+    | awk '/-----BEGIN CERTIFICATE-----/,/-----END CERTIFICATE-----/' > "$TMP/chain.pem" || true
+
+awk '/-----BEGIN CERTIFICATE-----/{n++} n==1' "$TMP/chain.pem" > "$TMP/leaf.pem"
+awk '/-----BEGIN CERTIFICATE-----/{n++} n>1'  "$TMP/chain.pem" > "$TMP/ca.pem"
+
+if [ ! -s "$TMP/leaf.pem" ] || [ ! -s "$TMP/ca.pem" ]; then
+    echo "Keine CA-Zertifikate von ${HOST}:${PORT} erhalten" >&2
+    exit 1
+fi
+
+# Vertrauen kommt nur aus dem System-Store, die gelieferte Kette dient als Zwischenglied
+if ! openssl verify -verify_hostname "$HOST" -untrusted "$TMP/ca.pem" "$TMP/leaf.pem" >"$TMP/verify.txt" 2>&1; then
+    echo "Kette von ${HOST}:${PORT} lässt sich nicht gegen den System-Store verifizieren, nichts gespeichert:" >&2
+    cat "$TMP/verify.txt" >&2
+    exit 1
+fi
+
+mkdir -p "$(dirname "$OUT")"
+mv "$TMP/ca.pem" "$OUT"
+echo "CA-Kette von ${HOST}:${PORT} geprüft und gespeichert in ${OUT}:"
+openssl crl2pkcs7 -nocrl -certfile "$OUT" | openssl pkcs7 -print_certs -noout | grep subject
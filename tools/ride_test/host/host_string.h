@@ -0,0 +1,19 @@
+// ==============================================
+// File: tools/ride_test/host/host_string.h
+// ==============================================
+// strlcpy für Host-libc ohne BSD-Erweiterungen (glibc < 2.38); newlib im IDF hat sie.
+#pragma once
+#include <string.h>
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+static inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
@@ -0,0 +1,331 @@
+// ==============================================
+// File: tools/ride_test/test_ride_stream.c
+// ==============================================
+// Host-Test für main/ride_stream.c: jede waitingtimes-Antwort unter fixtures/
+// wird in beliebigen Chunk-Aufteilungen gestreamt und pro Attraktion mit dem
+// früheren cJSON-Pfad (json_find_item_by_name) verglichen: gleiche Attraktion,
+// gleiche Wartezeit, gleicher Status, gleiche Schreibweise. Dazu der Fetch-Pfad
+// mit ride_collect_item: nach einem Treffer vor dem letzten Element endet der
+// Stream mit DONE, ohne den Rest zu lesen.
+//
+//   ./test_ride_stream fixtures/*.json
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "cJSON.h"
+#include "coaster_types.h"
+#include "ride_stream.h"
+#include "ride_table.h"
+
+static int s_failed;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FEHLER %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); s_failed++; } \
+} while (0)
+
+#define MAX_TARGETS  (RIDE_TABLE_SLOTS + 8)
+
+typedef struct {
+    bool             found;
+    int              waitingtime;
+    coaster_status_t status;
+    char             name[RIDE_STREAM_NAME_MAX];
+} lookup_t;
+
+// -----------------------------------------------------------------------------
+// Referenz: Suche und Übernahme wie vor dem Stream-Parser (api_client.c, cJSON)
+// -----------------------------------------------------------------------------
+static cJSON* json_find_item_by_name(cJSON* cJSON_root, const char *name)
+{
+    cJSON* cJSON_arr = NULL;
+    if (cJSON_IsArray(cJSON_root)) cJSON_arr = cJSON_root; else if (cJSON_IsObject(cJSON_root)) {
+        cJSON_arr = cJSON_GetObjectItem(cJSON_root, "data");
+        if (!cJSON_IsArray(cJSON_arr)) cJSON_arr = cJSON_GetObjectItem(cJSON_root, "items");
+        if (!cJSON_IsArray(cJSON_arr)) cJSON_arr = cJSON_GetObjectItem(cJSON_root, "results");
+        if (!cJSON_IsArray(cJSON_arr)) {
+            cJSON* cJSON_name = cJSON_GetObjectItem(cJSON_root, "name");
+            if (cJSON_IsString(cJSON_name) && strcasecmp(cJSON_name->valuestring, name) == 0) return cJSON_root;
+        }
+    }
+    if (!cJSON_IsArray(cJSON_arr)) return NULL;
+
+    cJSON* cJSON_item = NULL;
+    cJSON_ArrayForEach(cJSON_item, cJSON_arr) {
+        if (!cJSON_IsObject(cJSON_item)) continue;
+        cJSON* cJSON_name = cJSON_GetObjectItem(cJSON_item, "name");
+        if (cJSON_IsString(cJSON_name) && strcasecmp(cJSON_name->valuestring, name) == 0) return cJSON_item;
+    }
+    return NULL;
+}
+
+static lookup_t reference_lookup(cJSON* root, const char* name)
+{
+    lookup_t r = { .status = COASTER_UNKNOWN };
+    cJSON* coaster = json_find_item_by_name(root, name);
+    if (!coaster) return r;
+
+    cJSON* cJSON_waitingtime = cJSON_GetObjectItem(coaster, "waitingtime");
+    cJSON* cJSON_status      = cJSON_GetObjectItem(coaster, "status");
+    cJSON* cJSON_name        = cJSON_GetObjectItem(coaster, "name");
+
+    r.found = true;
+    if (cJSON_IsNumber(cJSON_waitingtime)) r.waitingtime = cJSON_waitingtime->valueint;
+    r.status = cJSON_IsString(cJSON_status) ? coaster_status_from_string(cJSON_status->valuestring)
+                                            : COASTER_UNKNOWN;
+    strlcpy(r.name, cJSON_IsString(cJSON_name) ? cJSON_name->valuestring : "", sizeof(r.name));
+    return r;
+}
+
+// Namen aller Attraktionen laut cJSON, als Suchbegriffe
+static int reference_names(cJSON* root, char names[][RIDE_STREAM_NAME_MAX], int max)
+{
+    cJSON* arr = root;
+    if (cJSON_IsObject(root)) {
+        arr = cJSON_GetObjectItem(root, "data");
+        if (!cJSON_IsArray(arr)) arr = cJSON_GetObjectItem(root, "items");
+        if (!cJSON_IsArray(arr)) arr = cJSON_GetObjectItem(root, "results");
+    }
+    int n = 0;
+    if (!cJSON_IsArray(arr)) {
+        cJSON* name = cJSON_GetObjectItem(root, "name");
+        if (cJSON_IsString(name)) strlcpy(names[n++], name->valuestring, RIDE_STREAM_NAME_MAX);
+        return n;
+    }
+    cJSON* item = NULL;
+    cJSON_ArrayForEach(item, arr) {
+        cJSON* name = cJSON_GetObjectItem(item, "name");
+        if (n < max && cJSON_IsObject(item) && cJSON_IsString(name)) {
+            strlcpy(names[n++], name->valuestring, RIDE_STREAM_NAME_MAX);
+        }
+    }
+    return n;
+}
+
+// -----------------------------------------------------------------------------
+// Stream-Pfad: Tabelle wie ride_collect_item in api_client.c
+// -----------------------------------------------------------------------------
+typedef struct {
+    ride_table_t table;
+    char         names[RIDE_TABLE_SLOTS][RIDE_STREAM_NAME_MAX];     // Schreibweise laut API pro Slot
+} collect_t;
+
+static bool collect_item(const ride_stream_item_t* item, void* ctx)
+{
+    collect_t* c = (collect_t*)ctx;
+    if (!item->has_name || item->name_truncated) return true;
+
+    uint8_t before = c->table.count;
+    int slot = ride_table_add(&c->table, item->name,
+                              item->has_waitingtime ? item->waitingtime : 0,
+                              item->has_status ? coaster_status_from_string(item->status) : COASTER_UNKNOWN);
+    if (slot >= 0 && c->table.count != before) strlcpy(c->names[slot], item->name, sizeof(c->names[slot]));
+    return true;
+}
+
+static lookup_t stream_lookup(const collect_t* c, const char* name)
+{
+    lookup_t r = { .status = COASTER_UNKNOWN };
+    int slot = ride_table_find(&c->table, name);
+    if (slot < 0) return r;
+    r.found       = true;
+    r.waitingtime = c->table.wait[slot];
+    r.status      = ride_table_status(&c->table, slot);
+    strlcpy(r.name, c->names[slot], sizeof(r.name));
+    return r;
+}
+
+// Fetch-Pfad: Tabelle über ride_collect_item wie in api_client.c, Ende nach dem Treffer.
+// *fed: vom Parser gelesene Bytes bis DONE/ERROR bzw. bis zum Ende
+static lookup_t collect_lookup(const char* buf, size_t len, size_t chunk, size_t max_rand,
+                               const char* target, size_t* fed, ride_stream_result_t* result);
+
+static uint32_t s_rng = 0x2545F491u;
+
+static uint32_t xorshift(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Füttert buf in Chunks; chunk > 0: feste Größe, 0: zufällige Größen 1..max_rand
+static bool stream_parse(const char* buf, size_t len, size_t chunk, size_t max_rand, collect_t* c)
+{
+    static ride_stream_t rs;
+    memset(c, 0, sizeof(*c));
+    ride_stream_init(&rs, collect_item, c);
+
+    size_t off = 0;
+    while (off < len) {
+        size_t n = chunk ? chunk : 1 + xorshift() % max_rand;
+        if (n > len - off) n = len - off;
+        if (ride_stream_feed(&rs, buf + off, n) != RIDE_STREAM_CONTINUE) break;
+        off += n;
+    }
+    return ride_stream_finish(&rs);
+}
+
+static lookup_t collect_lookup(const char* buf, size_t len, size_t chunk, size_t max_rand,
+                               const char* target, size_t* fed, ride_stream_result_t* result)
+{
+    static ride_stream_t rs;
+    static ride_table_t table;
+    static ride_collect_t rc;
+    ride_table_clear(&table);
+    rc = (ride_collect_t){ .rides = &table, .target = target };
+    ride_stream_init(&rs, ride_collect_item, &rc);
+
+    size_t off = 0;
+    while (off < len) {
+        size_t n = chunk ? chunk : 1 + xorshift() % max_rand;
+        if (n > len - off) n = len - off;
+        off += n;
+        if (ride_stream_feed(&rs, buf + off - n, n) != RIDE_STREAM_CONTINUE) break;
+    }
+    *fed = rs.consumed;
+    *result = rs.result;
+
+    lookup_t r = { .status = COASTER_UNKNOWN };
+    int slot = ride_table_find(&table, target);
+    if (ride_stream_finish(&rs) && rc.found && slot >= 0) {
+        r.found       = true;
+        r.waitingtime = table.wait[slot];
+        r.status      = ride_table_status(&table, slot);
+        strlcpy(r.name, rc.name, sizeof(r.name));
+    }
+    return r;
+}
+
+// -----------------------------------------------------------------------------
+
+static char* read_file(const char* path, size_t* len)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = malloc((size_t)size + 1);
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) { free(buf); buf = NULL; }
+    fclose(f);
+    if (!buf) return NULL;
+    buf[size] = '\0';
+    *len = (size_t)size;
+    return buf;
+}
+
+static bool same(const lookup_t* a, const lookup_t* b)
+{
+    if (a->found != b->found) return false;
+    if (!a->found) return true;
+    return a->waitingtime == b->waitingtime && a->status == b->status && strcmp(a->name, b->name) == 0;
+}
+
+static void test_fixture(const char* path)
+{
+    size_t len = 0;
+    char* buf = read_file(path, &len);
+    CHECK(buf != NULL, "%s nicht lesbar", path);
+    if (!buf) return;
+
+    cJSON* root = cJSON_Parse(buf);
+    CHECK(root != NULL, "%s: cJSON kann die Referenz nicht lesen", path);
+    if (!root) { free(buf); return; }
+
+    // Suchbegriffe: alle Namen, dieselben in Großbuchstaben und ein paar, die fehlen
+    static char targets[MAX_TARGETS][RIDE_STREAM_NAME_MAX];
+    int n = reference_names(root, targets, RIDE_TABLE_SLOTS);
+    int rides = n;
+    CHECK(n > 0, "%s: keine Attraktionen", path);
+    strlcpy(targets[n], targets[0], RIDE_STREAM_NAME_MAX);
+    for (char* p = targets[n]; *p; p++) {
+        if (*p >= 'a' && *p <= 'z') *p -= 'a' - 'A';
+    }
+    n++;
+    strlcpy(targets[n++], "Gibt es nicht", RIDE_STREAM_NAME_MAX);
+    targets[n++][0] = '\0';
+
+    static lookup_t expected[MAX_TARGETS];
+    for (int i = 0; i < n; i++) expected[i] = reference_lookup(root, targets[i]);
+
+    static const size_t fixed[] = { 1, 2, 3, 5, 7, 13, 64, 511, 1460, 0x7FFFFFFF };
+    const int rounds = (int)(sizeof(fixed) / sizeof(fixed[0])) + 200;
+    int splits = 0;
+    for (int r = 0; r < rounds; r++) {
+        static collect_t c;
+        bool fixed_round = r < (int)(sizeof(fixed) / sizeof(fixed[0]));
+        size_t chunk = fixed_round ? fixed[r] : 0;
+        size_t max_rand = (r & 1) ? 16 : 700;
+        bool ok = stream_parse(buf, len, chunk, max_rand, &c);
+        CHECK(ok, "%s: Parser meldet Fehler (Runde %d)", path, r);
+        splits++;
+
+        for (int i = 0; i < n; i++) {
+            lookup_t got = stream_lookup(&c, targets[i]);
+            CHECK(same(&got, &expected[i]),
+                  "%s (Runde %d) '%s': Stream %d/%d/%d/'%s', cJSON %d/%d/%d/'%s'", path, r, targets[i],
+                  got.found, got.waitingtime, (int)got.status, got.name,
+                  expected[i].found, expected[i].waitingtime, (int)expected[i].status, expected[i].name);
+        }
+
+        for (int i = 0; i < n; i++) {
+            size_t fed = 0;
+            ride_stream_result_t res;
+            lookup_t got = collect_lookup(buf, len, chunk, max_rand, targets[i], &fed, &res);
+            CHECK(res != RIDE_STREAM_ERROR, "%s: Parser meldet Fehler (Runde %d, '%s')", path, r, targets[i]);
+            CHECK(same(&got, &expected[i]),
+                  "%s (Runde %d) '%s' mit Abbruch: Stream %d/%d/%d/'%s', cJSON %d/%d/%d/'%s'", path, r, targets[i],
+                  got.found, got.waitingtime, (int)got.status, got.name,
+                  expected[i].found, expected[i].waitingtime, (int)expected[i].status, expected[i].name);
+            // Treffer vor dem letzten Element: der Rest der Antwort wird nicht mehr gelesen
+            if (i == 0 && rides > 1) {
+                CHECK(res == RIDE_STREAM_DONE && fed < len,
+                      "%s (Runde %d) '%s': kein Abbruch nach Treffer (%zu von %zu Bytes)", path, r, targets[i], fed, len);
+            }
+        }
+    }
+
+    // Abgeschnittene Antwort darf nicht als vollständig gelten
+    for (size_t cut = 1; cut < len; cut += 1 + len / 64) {
+        static collect_t c;
+        char save = buf[cut];
+        buf[cut] = '\0';
+        bool ref_ok = false;
+        cJSON* part = cJSON_Parse(buf);
+        if (part) { ref_ok = true; cJSON_Delete(part); }
+        buf[cut] = save;
+        CHECK(stream_parse(buf, cut, 0, 64, &c) == ref_ok, "%s: abgeschnitten nach %zu Bytes", path, cut);
+
+        // Mit Abbruch: entweder derselbe Treffer (Objekt war schon vollständig) oder keiner
+        for (int i = 0; i < n; i++) {
+            size_t fed = 0;
+            ride_stream_result_t res;
+            lookup_t got = collect_lookup(buf, cut, 0, 64, targets[i], &fed, &res);
+            CHECK(!got.found || same(&got, &expected[i]),
+                  "%s: abgeschnitten nach %zu Bytes, '%s' mit falschen Werten", path, cut, targets[i]);
+        }
+    }
+
+    printf("%s: %d Attraktionen, %d Aufteilungen\n", path, n, splits);
+    cJSON_Delete(root);
+    free(buf);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Aufruf: %s fixtures/*.json\n", argv[0]);
+        return 2;
+    }
+    for (int i = 1; i < argc; i++) test_fixture(argv[i]);
+
+    if (s_failed) {
+        printf("test_ride_stream: %d Fehler\n", s_failed);
+        return 1;
+    }
+    printf("test_ride_stream: OK\n");
+    return 0;
+}
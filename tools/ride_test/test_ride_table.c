@@ -0,0 +1,110 @@
+// ==============================================
+// File: tools/ride_test/test_ride_table.c
+// ==============================================
+// Host-Test für main/ride_table.c: Einfügen, Suche, Groß-/Kleinschreibung,
+// volle Tabelle und Namen mit gleichem FNV-1a-Hash.
+#include <stdio.h>
+
+#include "ride_table.h"
+
+static int s_failed;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FEHLER %s:%d: %s\n", __FILE__, __LINE__, #cond); s_failed++; } \
+} while (0)
+
+// Zwei Namen mit identischem FNV-1a-Hash (per Brute Force gesucht)
+#define COLLIDE_A "ride urzp"
+#define COLLIDE_B "ride mugbb"
+
+static void test_add_find(void)
+{
+    static ride_table_t t;
+    ride_table_clear(&t);
+
+    int a = ride_table_add(&t, "Blue Fire Megacoaster", 35, COASTER_OPENED);
+    int b = ride_table_add(&t, "Silver Star", 0, COASTER_MAINTENANCE);
+    CHECK(a == 0);
+    CHECK(b == 1);
+    CHECK(t.count == 2);
+
+    CHECK(ride_table_find(&t, "Blue Fire Megacoaster") == a);
+    CHECK(ride_table_find(&t, "blue fire MEGACOASTER") == a);
+    CHECK(ride_table_find(&t, "Silver Star") == b);
+    CHECK(ride_table_find(&t, "Silver Sta") == -1);
+    CHECK(ride_table_find(&t, "") == -1);
+    CHECK(ride_table_find(&t, NULL) == -1);
+
+    CHECK(t.wait[a] == 35);
+    CHECK(ride_table_status(&t, a) == COASTER_OPENED);
+    CHECK(ride_table_status(&t, b) == COASTER_MAINTENANCE);
+
+    // Doppelter Name: erster Eintrag bleibt
+    CHECK(ride_table_add(&t, "SILVER STAR", 99, COASTER_OPENED) == b);
+    CHECK(t.count == 2);
+    CHECK(t.wait[b] == 0);
+
+    // Unbekannter Status und Wertebereich
+    int c = ride_table_add(&t, "Eurosat", 100000, COASTER_UNKNOWN);
+    CHECK(ride_table_status(&t, c) == COASTER_UNKNOWN);
+    CHECK(t.wait[c] == INT16_MAX);
+}
+
+static void test_hash_collision(void)
+{
+    static ride_table_t t;
+    ride_table_clear(&t);
+
+    CHECK(ride_table_hash(COLLIDE_A) == ride_table_hash(COLLIDE_B));
+    CHECK(ride_table_check(COLLIDE_A) != ride_table_check(COLLIDE_B));
+
+    int a = ride_table_add(&t, COLLIDE_A, 10, COASTER_OPENED);
+    CHECK(ride_table_find(&t, COLLIDE_B) == -1);
+
+    int b = ride_table_add(&t, COLLIDE_B, 20, COASTER_CLOSED);
+    CHECK(a >= 0 && b >= 0 && a != b);
+    CHECK(t.count == 2);
+    CHECK(ride_table_find(&t, COLLIDE_A) == a);
+    CHECK(ride_table_find(&t, COLLIDE_B) == b);
+    CHECK(t.wait[ride_table_find(&t, COLLIDE_B)] == 20);
+}
+
+static void test_full(void)
+{
+    static ride_table_t t;
+    ride_table_clear(&t);
+
+    char name[32];
+    for (int i = 0; i < RIDE_TABLE_SLOTS; i++) {
+        snprintf(name, sizeof(name), "Attraktion %d", i);
+        CHECK(ride_table_add(&t, name, i, COASTER_OPENED) == i);
+    }
+    CHECK(!t.full);
+    CHECK(ride_table_add(&t, "Eine zu viel", 1, COASTER_OPENED) == -1);
+    CHECK(t.full);
+    CHECK(t.count == RIDE_TABLE_SLOTS);
+
+    // Vorhandene Einträge bleiben auffindbar, auch bei voller Tabelle
+    CHECK(ride_table_add(&t, "Attraktion 7", 0, COASTER_OPENED) == 7);
+    for (int i = 0; i < RIDE_TABLE_SLOTS; i++) {
+        snprintf(name, sizeof(name), "ATTRAKTION %d", i);
+        int slot = ride_table_find(&t, name);
+        CHECK(slot == i);
+        if (slot >= 0) CHECK(t.wait[slot] == i);
+    }
+    CHECK(ride_table_find(&t, "Eine zu viel") == -1);
+}
+
+int main(void)
+{
+    test_add_find();
+    test_hash_collision();
+    test_full();
+
+    if (s_failed) {
+        printf("test_ride_table: %d Fehler\n", s_failed);
+        return 1;
+    }
+    printf("test_ride_table: OK\n");
+    return 0;
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/env bash
+# Lokaler Test für CONFIG_API_TLS_PINNED_CA und tools/fetch_api_ca.sh, ohne
+# Netz und ohne Gerät: erzeugt selbstsignierte Ketten, startet openssl s_server
+# auf localhost und spielt die Entscheidungen von api_client.c nach.
+#
+#   Pin akzeptiert   Server-Kette passt zur gepinnten CA
+#   Pin abgelehnt    CA-Wechsel -> Zertifikatsfehler -> Fallback auf das Bundle
+#   kein Fallback    Verbindungsfehler ist keine Pin-Ablehnung
+#
+# Die Geräte-Seite wird mit s_client nachgebildet: gepinnte Datei als einzige
+# Vertrauensbasis mit Teilketten (wie mbedTLS mit cert_pem), das Bundle nur
+# mit Wurzeln (wie esp_crt_bundle).
+#
+#   tools/tls_pin_test.sh            (Port über TLS_TEST_PORT, Standard 48443)
+set -euo pipefail
+
+DIR="$(cd "$(dirname "$0")" && pwd)"
+PORT="${TLS_TEST_PORT:-48443}"
+HOST="localhost"
+TMP="$(mktemp -d)"
+SERVER_PID=""
+FAILED=0
+
+# ---------------------------------------------------------------------------
+# Zertifikate: Wurzel -> Zwischen-CA -> Leaf für localhost
+# ---------------------------------------------------------------------------
+mk_root()    # name
+{
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -days 2 \
+        -subj "/CN=$1 Root" -keyout "$TMP/$1_root.key" -out "$TMP/$1_root.pem" \
+        -addext "basicConstraints=critical,CA:true" -addext "keyUsage=critical,keyCertSign,cRLSign" \
+        2>/dev/null
+}
+
+mk_int()     # name
+{
+    openssl req -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes \
+        -subj "/CN=$1 Intermediate" -keyout "$TMP/$1_int.key" -out "$TMP/$1_int.csr" 2>/dev/null
+    printf 'basicConstraints=critical,CA:true,pathlen:0\nkeyUsage=critical,keyCertSign,cRLSign\n' > "$TMP/int.ext"
+    openssl x509 -req -in "$TMP/$1_int.csr" -CA "$TMP/$1_root.pem" -CAkey "$TMP/$1_root.key" \
+        -CAcreateserial -days 2 -extfile "$TMP/int.ext" -out "$TMP/$1_int.pem" 2>/dev/null
+}
+
+mk_leaf()    # name dnsname
+{
+    openssl req -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes \
+        -subj "/CN=$2" -keyout "$TMP/$1_leaf.key" -out "$TMP/$1_leaf.csr" 2>/dev/null
+    printf 'subjectAltName=DNS:%s\nextendedKeyUsage=serverAuth\n' "$2" > "$TMP/leaf.ext"
+    openssl x509 -req -in "$TMP/$1_leaf.csr" -CA "$TMP/$1_int.pem" -CAkey "$TMP/$1_int.key" \
+        -CAcreateserial -days 2 -extfile "$TMP/leaf.ext" -out "$TMP/$1_leaf.pem" 2>/dev/null
+}
+
+mk_chain()   # name dnsname
+{
+    mk_root "$1"; mk_int "$1"; mk_leaf "$1" "$2"
+}
+
+# ---------------------------------------------------------------------------
+# Server
+# ---------------------------------------------------------------------------
+start_server()   # name
+{
+    stop_server
+    openssl s_server -accept "$PORT" -cert "$TMP/$1_leaf.pem" -key "$TMP/$1_leaf.key" \
+        -cert_chain "$TMP/$1_int.pem" -www -quiet >/dev/null 2>&1 &
+    SERVER_PID=$!
+    for _ in $(seq 50); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then return 0; fi
+        sleep 0.1
+    done
+    echo "s_server auf Port $PORT startet nicht" >&2
+    exit 1
+}
+
+stop_server()
+{
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+        SERVER_PID=""
+    fi
+}
+
+cleanup()
+{
+    stop_server
+    rm -rf "$TMP"
+}
+trap cleanup EXIT
+
+# ---------------------------------------------------------------------------
+# Geräte-Seite
+# ---------------------------------------------------------------------------
+# Ein Verbindungsaufbau: "ok", "verify" (Zertifikat abgelehnt) oder "connect"
+tls_try()    # cafile [-partial_chain]
+{
+    local out
+    out="$(openssl s_client -connect "127.0.0.1:$PORT" -servername "$HOST" -verify_hostname "$HOST" \
+               -verify_return_error -no-CAfile -no-CApath -no-CAstore -CAfile "$1" ${2:-} \
+               </dev/null 2>&1)" || true
+    if   grep -q "Verify return code: 0 (ok)" <<<"$out"; then echo ok
+    elif grep -qi "verify error\|certificate verify failed" <<<"$out"; then echo verify
+    else echo connect
+    fi
+}
+
+# Wie api_fetch_task + api_retry_fallback: gepinnt, bei Zertifikatsfehler Bundle
+device_connect()   # pinned.pem bundle.pem
+{
+    local r
+    r="$(tls_try "$1" -partial_chain)"
+    case "$r" in
+        ok)      echo pinned ;;
+        verify)  [ "$(tls_try "$2")" = ok ] && echo bundle || echo failed ;;
+        *)       echo failed ;;
+    esac
+}
+
+expect()     # name expected actual
+{
+    if [ "$2" = "$3" ]; then
+        echo "ok      $1"
+    else
+        echo "FEHLER  $1: erwartet '$2', erhalten '$3'"
+        FAILED=$((FAILED + 1))
+    fi
+}
+
+fingerprint()
+{
+    openssl x509 -in "$1" -noout -fingerprint -sha256
+}
+
+# ---------------------------------------------------------------------------
+mk_chain a "$HOST"            # aktuelle CA des API-Hosts
+mk_chain b "$HOST"            # CA nach einem Wechsel, im Bundle enthalten
+mk_chain c "$HOST"            # unbekannte CA, nirgends vertrauenswürdig
+cp "$TMP/a_root.pem" "$TMP/a2_root.pem"; cp "$TMP/a_root.key" "$TMP/a2_root.key"
+mk_int a2; mk_leaf a2 "other.example"   # Wurzel von a, falscher Hostname
+
+cat "$TMP/a_root.pem" "$TMP/b_root.pem" > "$TMP/bundle.pem"
+mkdir -p "$TMP/empty"
+
+# fetch_api_ca.sh: nur mit verifizierbarer Kette speichern
+start_server a
+SSL_CERT_FILE="$TMP/a_root.pem" SSL_CERT_DIR="$TMP/empty" API_CA_OUT="$TMP/pinned.pem" \
+    "$DIR/fetch_api_ca.sh" "$HOST" "$PORT" >/dev/null 2>&1 && r=saved || r=refused
+expect "fetch_api_ca.sh speichert verifizierte Kette" saved "$r"
+expect "gespeichert wird die Zwischen-CA, nicht das Leaf" "$(fingerprint "$TMP/a_int.pem")" \
+       "$( [ -s "$TMP/pinned.pem" ] && fingerprint "$TMP/pinned.pem" || echo fehlt)"
+
+SSL_CERT_FILE="$TMP/b_root.pem" SSL_CERT_DIR="$TMP/empty" API_CA_OUT="$TMP/untrusted.pem" \
+    "$DIR/fetch_api_ca.sh" "$HOST" "$PORT" >/dev/null 2>&1 && r=saved || r=refused
+expect "fetch_api_ca.sh verweigert Kette ohne Vertrauensanker" refused "$r"
+expect "  und schreibt keine Datei" fehlt "$( [ -e "$TMP/untrusted.pem" ] && echo vorhanden || echo fehlt)"
+
+# Pin akzeptiert
+expect "Pin akzeptiert: gleiche CA" pinned "$(device_connect "$TMP/pinned.pem" "$TMP/bundle.pem")"
+
+# Pin abgelehnt -> Bundle
+start_server b
+expect "Pin abgelehnt nach CA-Wechsel, Fallback auf Bundle" bundle "$(device_connect "$TMP/pinned.pem" "$TMP/bundle.pem")"
+
+start_server c
+expect "Pin und Bundle lehnen unbekannte CA ab" failed "$(device_connect "$TMP/pinned.pem" "$TMP/bundle.pem")"
+
+start_server a2
+expect "Falscher Hostname wird trotz gepinnter CA abgelehnt" failed "$(device_connect "$TMP/pinned.pem" "$TMP/bundle.pem")"
+
+# Verbindungsfehler ist keine Pin-Ablehnung
+stop_server
+expect "Kein Server: kein Fallback" connect "$(tls_try "$TMP/pinned.pem" -partial_chain)"
+
+if [ "$FAILED" -ne 0 ]; then
+    echo "tls_pin_test: $FAILED Fehler"
+    exit 1
+fi
+echo "tls_pin_test: OK"
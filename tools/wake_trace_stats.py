@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+# Wertet die Wake-Zeitleiste aus (Konsolen-Log nach Reset oder trace.csv von
+# der SD-Karte) und gibt pro Abschnitt Anzahl und Perzentile der Dauer in ms aus.
+#
+#   tools/wake_trace_stats.py monitor.log [trace.csv ...]
+#   idf.py monitor | tee monitor.log
+import argparse
+import csv
+import math
+import sys
+from collections import defaultdict
+
+HEADER = "seq,cold,phase,start_us,dur_us"
+PERCENTILES = (50, 90, 99)
+
+
+def read_rows(lines):
+    """Liefert (seq, cold, phase, start_us, dur_us) aus allen CSV-Blöcken im Log."""
+    in_block = False
+    for line in lines:
+        line = line.strip()
+        if line == HEADER:
+            in_block = True
+            continue
+        if not in_block or line.startswith("#"):
+            continue
+        fields = next(csv.reader([line]))
+        if len(fields) != 5:
+            in_block = False    # Ende des Dumps, normales Log geht weiter
+            continue
+        try:
+            yield int(fields[0]), fields[1] == "1", fields[2], int(fields[3]), int(fields[4])
+        except ValueError:
+            in_block = False
+
+
+def percentile(values, p):
+    """Nearest-rank auf sortierter Liste."""
+    k = max(0, math.ceil(p / 100.0 * len(values)) - 1)
+    return values[k]
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Perzentile der Wake-Zeitleiste")
+    ap.add_argument("files", nargs="*", help="Log- oder CSV-Dateien (ohne: stdin)")
+    ap.add_argument("--cold", choices=("all", "only", "exclude"), default="exclude",
+                    help="Kaltstarts (mit 10 s Flash-Fenster) einbeziehen (Standard: exclude)")
+    args = ap.parse_args()
+
+    rows = {}
+    sources = [open(f, encoding="utf-8", errors="replace") for f in args.files] or [sys.stdin]
+    for src in sources:
+        for seq, cold, phase, start, dur in read_rows(src):
+            if (args.cold == "exclude" and cold) or (args.cold == "only" and not cold):
+                continue
+            # Mehrere Dumps enthalten dieselben Wakes -> über (seq, phase, start) entdoppeln
+            rows[(seq, phase, start)] = dur
+
+    # Abschnitte, die mehrfach pro Wake vorkommen (z.B. epd_busy), pro Wake aufsummieren
+    per_wake = defaultdict(lambda: defaultdict(int))
+    for (seq, phase, _), dur in rows.items():
+        per_wake[phase][seq] += dur
+
+    if not per_wake:
+        print("Keine Trace-Daten gefunden", file=sys.stderr)
+        return 1
+
+    wakes = len({seq for (seq, _, _) in rows})
+    cols = ["phase", "n"] + ["p%d" % p for p in PERCENTILES] + ["max"]
+    print("%d Wakes" % wakes)
+    print("%-18s %5s" % tuple(cols[:2]) + "".join("%10s" % c for c in cols[2:]))
+    order = sorted(per_wake, key=lambda ph: -percentile(sorted(per_wake[ph].values()), 50))
+    for phase in order:
+        ms = sorted(v / 1000.0 for v in per_wake[phase].values())
+        vals = [percentile(ms, p) for p in PERCENTILES] + [ms[-1]]
+        print("%-18s %5d" % (phase, len(ms)) + "".join("%10.1f" % v for v in vals))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())